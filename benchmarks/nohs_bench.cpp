@@ -0,0 +1,250 @@
+#include <map>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <benchmark/benchmark.h>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#include "nohs.h"
+#include "nohs_optimizer.h"
+
+// Synthetic inputs: the quartic double-well potential of the quartic example and uniform grids of points.
+static double Quartic(double x, void* pvoid){
+    double barrier = *(double *) pvoid;
+    return barrier*std::pow(x*x - 1., 2.);
+}
+
+static double barrier = 40.;
+
+static std::vector<double> uniform_grid(int npt, double x_min, double x_max){
+    std::vector<double> grid(npt);
+    for(int i=0; i<npt; i++) grid[i] = x_min + (x_max - x_min)*i/(npt - 1.);
+    return grid;
+}
+
+// Basis-set of N functions: half centered in the origin and a quarter on each minimum of the potential
+static std::vector<nohs::Hermite> quartic_basis(int N){
+    std::vector<nohs::Hermite> BasisSet;
+    for(int order=0; order<N - 2*(N/4); order++) BasisSet.push_back(nohs::Hermite(order, 3., 0.));
+    for(double center : {-1., 1.}){
+        for(int order=0; order<N/4; order++) BasisSet.push_back(nohs::Hermite(order, 4.3, center));
+    }
+    return BasisSet;
+}
+
+static void set_threads(int threads){
+    #ifdef _OPENMP
+        omp_set_num_threads(threads);
+    #else
+        (void) threads;
+    #endif
+}
+
+static int get_threads(){
+    #ifdef _OPENMP
+        return omp_get_max_threads();
+    #else
+        return 1;
+    #endif
+}
+
+
+// Hermite function kernels: range(0) is the order of the function
+static void hermite_kernel(benchmark::State& state, int derivative){
+    nohs::Hermite function(int(state.range(0)), 2., 0.3);
+    std::vector<double> grid = uniform_grid(1000, -4., 4.);
+    for(auto _ : state){
+        double sum = 0.;
+        for(double x : grid){
+            sum += derivative == 0 ? function.f(x) : (derivative == 1 ? function.d1f(x) : function.d2f(x));
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()*int64_t(grid.size()));
+}
+
+static void BM_Hermite_f(benchmark::State& state){ hermite_kernel(state, 0); }
+static void BM_Hermite_d1f(benchmark::State& state){ hermite_kernel(state, 1); }
+static void BM_Hermite_d2f(benchmark::State& state){ hermite_kernel(state, 2); }
+
+BENCHMARK(BM_Hermite_f)->Arg(0)->Arg(5)->Arg(20)->Arg(50)->Arg(100);
+BENCHMARK(BM_Hermite_d1f)->Arg(0)->Arg(5)->Arg(20)->Arg(50)->Arg(100);
+BENCHMARK(BM_Hermite_d2f)->Arg(0)->Arg(5)->Arg(20)->Arg(50)->Arg(100);
+
+
+// Complete solution (assembly with the default QAGI integration and diagonalization): range(0) is the number
+// of basis functions and range(1) the number of OpenMP threads
+static void BM_Solve(benchmark::State& state){
+    std::vector<nohs::Hermite> BasisSet = quartic_basis(int(state.range(0)));
+    int threads = get_threads();
+    set_threads(int(state.range(1)));
+    for(auto _ : state){
+        nohs::Solver System(BasisSet, &Quartic, &barrier);
+        System.solve(1e-8);
+        benchmark::DoNotOptimize(System.energy(0));
+    }
+    set_threads(threads);
+    state.counters["functions"] = double(state.range(0));
+    state.counters["threads"] = double(state.range(1));
+}
+
+BENCHMARK(BM_Solve)->ArgsProduct({{20, 40, 80}, {1, 2, 4}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+
+// Eigenfunction evaluation on a solved system: range(0) is the number of points
+static nohs::Solver& solved_system(){
+    static nohs::Solver System(quartic_basis(60), nohs::PolynomialPotential({barrier, 0., -2.*barrier, 0., barrier}));
+    static bool solved = false;
+    if(solved == false){
+        System.solve(1e-8);
+        solved = true;
+    }
+    return System;
+}
+
+static void BM_Psi(benchmark::State& state){
+    nohs::Solver& System = solved_system();
+    std::vector<double> grid = uniform_grid(int(state.range(0)), -2.5, 2.5);
+    for(auto _ : state){
+        double sum = 0.;
+        for(double x : grid) sum += System.psi(0, x);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()*state.range(0));
+}
+
+static void BM_PsiGrid(benchmark::State& state){
+    nohs::Solver& System = solved_system();
+    std::vector<double> grid = uniform_grid(int(state.range(0)), -2.5, 2.5);
+    std::vector<int> states = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    for(auto _ : state){
+        arma::mat psi = System.psi_grid(states, grid);
+        benchmark::DoNotOptimize(psi.memptr());
+    }
+    state.SetItemsProcessed(state.iterations()*state.range(0)*int64_t(states.size()));
+}
+
+BENCHMARK(BM_Psi)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_PsiGrid)->Arg(1000)->Arg(10000);
+
+
+// Basis-set optimization of the quartic example: range(0) selects the minimizer (0 simplex, 1 gradient)
+static void BM_Optimize(benchmark::State& state){
+    nohs::PolynomialPotential Potential({barrier, 0., -2.*barrier, 0., barrier});
+    for(auto _ : state){
+        nohs::Optimizer MyOptimizer(Potential);
+        MyOptimizer.set_minimizer(state.range(0) == 0 ? nohs::Minimizer::SIMPLEX : nohs::Minimizer::GRADIENT);
+        MyOptimizer.add(0., 10, 3., 0);
+        MyOptimizer.add(1., 5, 3., 1);
+        MyOptimizer.add(-1., 5, 3., 1);
+        MyOptimizer.optimize(200, 1e-5, false);
+        benchmark::DoNotOptimize(MyOptimizer.get_energy());
+    }
+}
+
+BENCHMARK(BM_Optimize)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+
+// Baseline comparison: the console reporter also records the real time of each benchmark so that it can be
+// compared with the one stored in a JSON file written by a previous run with --benchmark_out=<file>.
+class BaselineReporter : public benchmark::ConsoleReporter{
+    public:
+        std::map<std::string, double> times;
+        void ReportRuns(const std::vector<Run>& reports) override {
+            for(const Run& run : reports){
+                if(run.run_type != Run::RT_Iteration || run.error_occurred == true) continue;
+                std::string name = run.benchmark_name();
+                double time = run.GetAdjustedRealTime();
+                times[name] = times.count(name) == 0 ? time : std::min(times[name], time);   //The best of the repetitions
+            }
+            ConsoleReporter::ReportRuns(reports);
+        }
+};
+
+// Extracts the "name" and "real_time" fields of the iteration entries of a Google Benchmark JSON output
+static std::map<std::string, double> read_baseline(const std::string& path){
+    std::ifstream file(path);
+    if(!file) throw std::runtime_error("Cannot open the baseline file " + path);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    auto field = [&text](const std::string& key, size_t from, size_t to) -> std::string {
+        size_t position = text.find("\"" + key + "\":", from);
+        if(position == std::string::npos || position >= to) return "";
+        position = text.find_first_not_of(" \t\n", position + key.size() + 3);
+        if(text[position] == '"') return text.substr(position + 1, text.find('"', position + 1) - position - 1);
+        return text.substr(position, text.find_first_of(",}\n", position) - position);
+    };
+
+    std::map<std::string, double> times;
+    size_t start = text.find("\"benchmarks\"");
+    while(start != std::string::npos){
+        size_t begin = text.find('{', start);
+        if(begin == std::string::npos) break;
+        size_t end = text.find('}', begin);
+        std::string name = field("name", begin, end);
+        std::string type = field("run_type", begin, end);
+        std::string time = field("real_time", begin, end);
+        if(name.empty() == false && time.empty() == false && (type.empty() == true || type == "iteration")){
+            double value = std::stod(time);
+            times[name] = times.count(name) == 0 ? value : std::min(times[name], value);
+        }
+        start = end;
+    }
+    return times;
+}
+
+int main(int argc, char** argv){
+
+    // Own options: --baseline=<file> enables the comparison, --tolerance=<fraction> sets the accepted slowdown
+    std::string baseline;
+    double tolerance = 0.1;
+    std::vector<char*> arguments;
+    for(int i=0; i<argc; i++){
+        std::string argument = argv[i];
+        if(argument.compare(0, 11, "--baseline=") == 0) baseline = argument.substr(11);
+        else if(argument.compare(0, 12, "--tolerance=") == 0) tolerance = std::stod(argument.substr(12));
+        else arguments.push_back(argv[i]);
+    }
+    int count = int(arguments.size());
+
+    benchmark::Initialize(&count, arguments.data());
+    if(benchmark::ReportUnrecognizedArguments(count, arguments.data())) return 1;
+
+    if(baseline.empty() == true){
+        benchmark::RunSpecifiedBenchmarks();
+        benchmark::Shutdown();
+        return 0;
+    }
+
+    std::map<std::string, double> reference = read_baseline(baseline);
+    BaselineReporter reporter;
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    benchmark::Shutdown();
+
+    int regressions = 0;
+    std::cout << std::endl << "Comparison with " << baseline << " (tolerance " << 100.*tolerance << "%):" << std::endl;
+    for(const std::pair<const std::string, double>& entry : reporter.times){
+        std::map<std::string, double>::const_iterator old = reference.find(entry.first);
+        if(old == reference.end()){
+            std::cout << "        " << entry.first << " -> not in baseline" << std::endl;
+            continue;
+        }
+        double change = entry.second/old->second - 1.;
+        bool regression = change > tolerance;
+        if(regression == true) regressions++;
+        std::cout << "        " << entry.first << " -> " << (change >= 0. ? "+" : "") << 100.*change << "%" << (regression == true ? " REGRESSION" : "") << std::endl;
+    }
+    std::cout << regressions << " regression(s) found" << std::endl;
+
+    return regressions == 0 ? 0 : 2;
+}
\ No newline at end of file
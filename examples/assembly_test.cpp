@@ -0,0 +1,58 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <vector>
+#include "nohs.h"
+
+static double Quartic(double x, void* pvoid){
+    double delta = *(double *) pvoid;
+    return delta*std::pow(x*x - 1., 2.);
+}
+
+static bool check(std::string name, double value, double reference, double tolerance){
+    bool passed = std::fabs(value - reference) <= tolerance;
+    std::cout << std::setprecision(12) << name << ": " << value << " (reference: " << reference << ") -> " << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed;
+}
+
+static double ground_state(std::vector<nohs::Hermite> BasisSet, double* barrier, nohs::Assembly mode){
+    nohs::Solver System(BasisSet, &Quartic, barrier);
+    System.set_assembly_mode(mode);
+    System.solve(1e-8);
+    return System.energy(0);
+}
+
+int main(){
+
+    const double tolerance = 1e-8;
+    double barrier = 40.;
+    bool passed = true;
+
+    // Isolated group: the whole potential matrix is computed in the discrete variable representation
+    std::vector<nohs::Hermite> Isolated;
+    for(int n=0; n<=40; n++) Isolated.push_back(nohs::Hermite(n, 3.11876, 0.));
+    double E_qagi = ground_state(Isolated, &barrier, nohs::Assembly::QUADRATURE);
+    double E_dvr = ground_state(Isolated, &barrier, nohs::Assembly::DVR);
+    passed &= check("Isolated group, DVR vs QAGI", E_dvr, E_qagi, tolerance);
+
+    // Overlapping groups: the DVR must fall back to the integration backend for all of them
+    std::vector<nohs::Hermite> Mixed = Isolated;
+    for(double center : {-1., 1.}){
+        for(int n=0; n<=20; n++) Mixed.push_back(nohs::Hermite(n, 4.27538, center));
+    }
+    E_qagi = ground_state(Mixed, &barrier, nohs::Assembly::QUADRATURE);
+    E_dvr = ground_state(Mixed, &barrier, nohs::Assembly::DVR);
+    passed &= check("Mixed groups, DVR vs QAGI", E_dvr, E_qagi, tolerance);
+
+    // A plain re-solve after changing the potential parameters must recompute the matrices
+    nohs::Solver System(Mixed, &Quartic, &barrier);
+    System.solve(1e-8);
+    barrier = 20.;
+    System.solve(1e-8);
+    double E_fresh = ground_state(Mixed, &barrier, nohs::Assembly::QUADRATURE);
+    passed &= check("Re-solve vs fresh solve", System.energy(0), E_fresh, tolerance);
+
+    std::cout << std::endl << (passed ? "All the checks PASSED" : "Some checks FAILED") << std::endl;
+
+    return passed ? 0 : 1;
+}
\ No newline at end of file
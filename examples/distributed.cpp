@@ -0,0 +1,52 @@
+#include <iostream>
+#include <cmath>
+#include <mpi.h>
+#include "nohs.h"
+
+// Assembly of a large multi-center basis-set distributed among MPI processes, to be run with e.g.:
+// mpirun -np 4 ./distributed
+static double Quartic(double x, void* pvoid){
+    double barrier = *(double *) pvoid;
+    return barrier*std::pow(x*x - 1., 2.);
+}
+
+int main(int argc, char** argv){
+
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    double barrier = 40.;
+    int centers = 21;
+    int order = 14;
+
+    std::vector<nohs::Hermite> BasisSet;
+    for(int c=0; c<centers; c++){
+        double center = -2. + 4.*c/(centers - 1.);
+        for(int n=0; n<order; n++) BasisSet.push_back(nohs::Hermite(n, 4., center));
+    }
+
+    nohs::Solver System(BasisSet, &Quartic, &barrier);
+    System.set_profiling(true);
+    System.solve(1e-8);
+
+    double assembly = System.get_profile().assembly, slowest;
+    MPI_Reduce(&assembly, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if(rank == 0){
+        std::cout << "Processes: " << size << std::endl;
+        std::cout << "Basis functions: " << BasisSet.size() << std::endl;
+        std::cout << "Effective Basis functions: " << System.get_N_reduced() << std::endl;
+        std::cout << "Assembly time (s): " << slowest << std::endl << std::endl;
+        std::cout << "n" << '\t' << "Energy" << std::endl;
+        std::cout << "---------------------------------------" << std::endl;
+        for(int i=0; i<6; i++){
+            std::cout << i << ")\t" << System.energy(i) << std::endl;
+        }
+    }
+
+    MPI_Finalize();
+    return 0;
+}
\ No newline at end of file
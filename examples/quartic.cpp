@@ -29,7 +29,9 @@ int main(){
     std::cout << "Basis-set optimization:" << std::endl;
     std::cout << "---------------------------------------" << std::endl;
 
-    nohs::Optimizer MyOptimizer(&Quartic, &barrier);
+    nohs::PolynomialPotential Potential({barrier, 0., -2.*barrier, 0., barrier});
+
+    nohs::Optimizer MyOptimizer(Potential);
     MyOptimizer.add(0., 10, alpha_guess, 0);
     MyOptimizer.add(1., 5, alpha_guess, 1);
     MyOptimizer.add(-1., 5, alpha_guess, 1);
@@ -39,7 +41,7 @@ int main(){
 
     std::vector<int> order = {N_max, N_min, N_min};
     std::vector<nohs::Hermite> BasisSet = MyOptimizer.generate_basis_set(order);
-    nohs::Solver System(BasisSet, &Quartic, &barrier);
+    nohs::Solver System(BasisSet, Potential);
     System.solve(1e-8);
 
     std::cout << "Effective Basis functions: " << System.get_N_reduced() << std::endl << std::endl;
@@ -59,11 +61,16 @@ int main(){
 
     int npt_plot = 10000;
     int max_psi = 4;
+    std::vector<double> grid;
+    for(int i=0; i<=npt_plot; i++) grid.push_back(-2.5 + 5.*i/npt_plot);
+    std::vector<int> states;
+    for(int j=0; j<=max_psi; j++) states.push_back(j);
+    arma::mat psi = System.psi_grid(states, grid);
+
     std::ofstream file("quartic.txt");
     for(int i=0; i<=npt_plot; i++){
-        double x = -2.5 + 5.*i/npt_plot;
-        file << x << '\t' << Quartic(x, &barrier);
-        for(int j=0; j<=max_psi; j++) file << '\t' << System.psi(j, x);
+        file << grid[i] << '\t' << Quartic(grid[i], &barrier);
+        for(int j=0; j<=max_psi; j++) file << '\t' << psi(i, j);
         file << std::endl;
     }
     file.close();
@@ -1,14 +1,26 @@
 #ifndef NOHS_H
 #define NOHS_H
 
+#include <cmath>
+#include <string>
 #include <vector>
+#include <memory>
+#include <cstdint>
+#include <utility>
 #include <armadillo>
+#include <gsl/gsl_integration.h>
 
 namespace nohs{
 
     class Hermite;
+    class HermiteFamily;
+    class PolynomialPotential;
     class Solver;
 
+    enum class Assembly{ QUADRATURE, GRID, DVR };
+    enum class Storage{ DENSE, SPARSE };
+    enum class Integration{ QAGI, QAG, GAUSS_HERMITE };
+
     namespace utils{
 
         struct Carrier{
@@ -20,10 +32,48 @@ namespace nohs{
         };
 
         inline double aux_func_gsl(double x, void* pvoid){
-            Carrier data = *(Carrier*) pvoid;
+            const Carrier& data = *static_cast<const Carrier*>(pvoid);
             return ((*(data.cpt)).*(data.fpt))(data.r, data.c, x);
         }
 
+        double wall_time();
+
+        // Value at x of the Hermite function of order `order`, defined inline so that the integrands of the solvers
+        // can be compiled together with the recurrence
+        inline double hermite_function(int order, double alpha, double center, double x){
+            double y = alpha*(x-center);
+            double cur = std::sqrt(alpha/std::sqrt(M_PI))*std::exp(-0.5*y*y);
+            double next = std::sqrt(2.)*y*cur;
+            for(int i=2; i<=order+1; i++){
+                double var = y*std::sqrt(2./i)*next - std::sqrt((i-1.)/i)*cur;
+                cur = next;
+                next = var;
+            }
+            return cur;
+        }
+
+        // Orders, alpha and center of the two functions of a matrix element, passed to the integrands of the solvers
+        struct PairCarrier{
+            Solver* cpt;
+            int order_a, order_b;
+            double alpha_a, center_a, alpha_b, center_b;
+        };
+
+        typedef double (*PairIntegrand)(double, void*);
+
+        class WorkspacePool{
+            private:
+                size_t npt;
+                std::vector<gsl_integration_workspace*> workspaces;
+            public:
+                WorkspacePool();
+                WorkspacePool(const WorkspacePool&) = delete;
+                WorkspacePool& operator=(const WorkspacePool&) = delete;
+                ~WorkspacePool();
+                void reserve(int threads_, size_t npt_);
+                gsl_integration_workspace* get(int thread_);
+        };
+
     }
 
     class Hermite{
@@ -34,36 +84,135 @@ namespace nohs{
         public:
             Hermite();
             Hermite(int order_, double alpha_, double center_);
-            double f(double x_);
-            double d1f(double x_);
-            double d2f(double x_);
+            double f(double x_) const;
+            double d1f(double x_) const;
+            double d2f(double x_) const;
+            int get_order() const;
+            double get_alpha() const;
+            double get_center() const;
+    };
+
+    class HermiteFamily{
+        private:
+            bool init;
+            int max_order;
+            double alpha, center;
+        public:
+            HermiteFamily();
+            HermiteFamily(int max_order_, double alpha_, double center_);
+            void evaluate(double x_, double* f_, double* d1f_, double* d2f_) const;
+            void evaluate(int npt_, const double* x_, double* f_, double* d1f_, double* d2f_) const;
+    };
+
+    class PolynomialPotential{
+        private:
+            std::vector<double> coefficients;
+        public:
+            PolynomialPotential();
+            PolynomialPotential(std::vector<double> coefficients_);
+            int degree() const;
+            double coefficient(int power_) const;
+            double operator()(double x_) const;
+            static double function(double x_, void* pvoid);
+    };
+
+    struct Profile{
+        long solves, pairs, integrand_evaluations, potential_evaluations, subintervals;
+        int failures;
+        double max_error;
+        double assembly, symmetrization, orthogonalization, transform, diagonalization, total;
+        std::vector<double> thread_busy;
+        std::vector<long> thread_pairs;
+        Profile();
+        void accumulate(const Profile& other_);
+        std::string json() const;
     };
 
     class Solver{
         private:
             bool solved;
-            int N, N_red, npt;
-            double abs, rel;
+            int N, N_assembled, N_red, N_states, npt;
+            double abs, rel, margin, density;
+            Assembly mode;
+            Integration integration;
+            bool reflection, kinetic;
+            Storage storage;
+            double screening;
+            int sparse_max_iter;
+            double sparse_tol;
             std::vector<Hermite> BasisSet;
+            std::vector<std::vector<int>> groups;
+            std::vector<int> mirror, state_parity;
             arma::mat H, S, C;
+            arma::sp_mat H_sparse, S_sparse;
             arma::vec E;
             double (*V)(double, void*);
             void* parameters;
+            bool polynomial;
+            PolynomialPotential polynomial_potential;
+            std::shared_ptr<utils::WorkspacePool> pool;
+            std::shared_ptr<char> mapping;
+            bool profiling;
+            Profile profile;
+            bool distribute, reuse;
             
-            double overlap_integrand(int row, int col, double x);
-            double hamiltonian_integrand(int row, int col, double x);
+            uint64_t checkpoint_hash(const std::vector<Hermite>& BasisSet_, const std::vector<double>& key_);
+            static double function_integrand(double x, void* pvoid);
+            void build_groups();
+            void build_mirror();
+            void evaluate_basis(int npt_, const double* x_, int ld_, double* F_, double* D1_, double* D2_);
+            std::vector<double> basis_grid(double& step_);
+            std::vector<arma::mat> dvr_blocks();
+            arma::mat operator_matrix(double (*O_)(double, void*), void* parameters_, const PolynomialPotential* polynomial_);
+            arma::mat project(std::vector<int> index_list_, const arma::mat& O_);
+            void integrate_pairs(const std::vector<std::pair<int, int>>& pairs, const std::vector<arma::mat>* dvr = nullptr);
+            void quadrature_assembly();
+            void grid_assembly();
+            void assemble();
+
+        protected:
+            virtual utils::PairIntegrand pair_integrand();
+            virtual double potential(double x_);
+            virtual void potential(int npt_, const double* x_, double* V_);
 
         public:
             Solver(unsigned int N_, double (*V_)(double, void*), void* parameters_);
             Solver(std::vector<Hermite> BasisSet_, double (*V_)(double, void*), void* parameters_);           
+            Solver(unsigned int N_, PolynomialPotential V_);
+            Solver(std::vector<Hermite> BasisSet_, PolynomialPotential V_);
+            virtual ~Solver();
             void set_integration_parameters(unsigned int npt_, double abs_, double rel_);
+            void set_integration_parameters(Integration method_, unsigned int npt_, double abs_, double rel_);
+            void set_assembly_mode(Assembly mode_);
+            void set_grid_parameters(double margin_, double density_);
+            void set_reflection_symmetry(bool enable_);
+            void set_storage(Storage storage_);
+            void set_screening(double tolerance_);
+            void set_sparse_parameters(unsigned int max_iter_, double tol_);
+            void set_workspace_pool(std::shared_ptr<utils::WorkspacePool> pool_);
+            void set_profiling(bool enable_);
+            void set_distributed(bool enable_);
             void add(Hermite function_);
             void solve(double threshold_);
+            void solve(double threshold_, int n_states_);
+            void save(std::string path_, std::vector<double> key_ = std::vector<double>());
+            void load(std::string path_, std::vector<double> key_ = std::vector<double>());
             int get_N_reduced();
+            int get_N_states();
+            const Profile& get_profile();
             double energy(int index_);
+            int parity(int index_);
             double psi(int index_, double x_);
+            arma::mat psi_grid(std::vector<int> index_list_, std::vector<double> x_, int derivative_ = 0);
+            arma::mat psi_all(std::vector<double> x_, int derivative_ = 0);
+            arma::mat density_grid(std::vector<int> index_list_, std::vector<double> x_);
+            arma::mat observable(std::vector<int> index_list_, double (*O_)(double, void*), void* parameters_);
+            arma::mat observable(std::vector<int> index_list_, PolynomialPotential O_);
 
             friend double utils::aux_func_gsl(double x, void* pvoid);
+            friend class ParametricSolver;
+            friend class Optimizer;
+            friend class Propagator;
 
     };
 
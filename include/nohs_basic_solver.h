@@ -0,0 +1,61 @@
+#ifndef NOHS_BASIC_SOLVER_H
+#define NOHS_BASIC_SOLVER_H
+
+#include <vector>
+
+#include "nohs.h"
+
+namespace nohs{
+
+    namespace utils{
+
+        // Potentials exposing a batched `void operator()(const double* x, double* out, int n)` overload are
+        // called once for each block of points, all the others are called point by point from an inlinable loop.
+        template <typename Potential>
+        inline auto batch_call(Potential& V, int npt, const double* x, double* out, int) -> decltype(V(x, out, npt), void()) {
+            V(x, out, npt);
+        }
+
+        template <typename Potential>
+        inline void batch_call(Potential& V, int npt, const double* x, double* out, long) {
+            for(int k=0; k<npt; k++) out[k] = V(x[k]);
+        }
+
+    }
+
+    template <typename Potential>
+    class BasicSolver : public Solver{
+        private:
+            Potential functor;
+
+            // Integrand of the adaptive routines: the potential and the Hermite recurrences are compiled together
+            static double integrand(double x, void* pvoid){
+                const utils::PairCarrier& data = *static_cast<const utils::PairCarrier*>(pvoid);
+                BasicSolver& self = *static_cast<BasicSolver*>(data.cpt);
+                double a = utils::hermite_function(data.order_a, data.alpha_a, data.center_a, x);
+                double b = utils::hermite_function(data.order_b, data.alpha_b, data.center_b, x);
+                return a*self.functor(x)*b;
+            }
+        protected:
+            utils::PairIntegrand pair_integrand() override {
+                return &BasicSolver::integrand;
+            }
+            double potential(double x_) override {
+                return functor(x_);
+            }
+            void potential(int npt_, const double* x_, double* V_) override {
+                utils::batch_call(functor, npt_, x_, V_, 0);
+            }
+        public:
+            BasicSolver(unsigned int N_, Potential V_) : Solver(N_, nullptr, nullptr), functor(V_) {}
+            BasicSolver(std::vector<Hermite> BasisSet_, Potential V_) : Solver(BasisSet_, nullptr, nullptr), functor(V_) {}
+    };
+
+    template <typename Potential>
+    BasicSolver<Potential> make_solver(std::vector<Hermite> BasisSet_, Potential V_){
+        return BasicSolver<Potential>(BasisSet_, V_);
+    }
+
+}
+
+#endif
\ No newline at end of file
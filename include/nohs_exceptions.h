@@ -30,18 +30,36 @@ namespace nohs{
             }
         };
 
+        class PrepareError: public std::exception {
+            virtual const char* what() const throw(){
+                return "Cannot access requested data without a prior call to prepare()";
+            }
+        };
+
         class BoundError: public std::exception {
             virtual const char* what() const throw(){
                 return "Index out of bounds";
             }
         };
 
+        class EigenError: public std::exception {
+            virtual const char* what() const throw(){
+                return "The eigenvalue problem solver failed";
+            }
+        };
+
         class InvalidError: public std::exception {
             virtual const char* what() const throw(){
                 return "Invalid value passed as an argument";
             }
         };
 
+        class CheckpointError: public std::exception {
+            virtual const char* what() const throw(){
+                return "Cannot read, write or use the requested checkpoint file";
+            }
+        };
+
     }
 }
 
@@ -1,7 +1,10 @@
 #ifndef NOHS_OPTIMIZATION_H
 #define NOHS_OPTIMIZATION_H
 
+#include <map>
+#include <tuple>
 #include <vector>
+#include <memory>
 #include <gsl/gsl_multimin.h>
 
 #include "nohs.h"
@@ -9,25 +12,60 @@
 
 namespace nohs{
 
+    enum class Minimizer{ SIMPLEX, GRADIENT };
+
     double minimization_target(const gsl_vector* v, void* pvoid);
+    void minimization_gradient(const gsl_vector* v, void* pvoid, gsl_vector* df);
+    void minimization_fdf(const gsl_vector* v, void* pvoid, double* f, gsl_vector* df);
 
     class Optimizer{
         private:
             bool optimized;
             int N_labels, npt;
-            double abs, rel;
+            double abs, rel, step_size;
+            Minimizer method;
+            Integration integration;
             std::vector<int> max_order, label;
             std::vector<double> center, guess, optimized_alpha;
+            double optimized_energy;
             double (*V)(double, void*);
             void* parameters;
+            bool polynomial;
+            PolynomialPotential polynomial_potential;
+            std::shared_ptr<utils::WorkspacePool> pool;
+            std::unique_ptr<Solver> system;
+            std::vector<int> offset;
+            int extra_orders;
+            struct CachedBlock{
+                long last_use;
+                arma::mat S, H;
+            };
+            std::map<std::tuple<int, int, double, double>, CachedBlock> cache;
+            long evaluations;
+            bool profiling;
+            Profile profile;
+
+            void build_system(int extra_);
+            double ground_state(const gsl_vector* v, const std::vector<int>& assignment, gsl_vector* gradient);
+
         public:
             Optimizer(double (*V_)(double, void*), void* parameters_);
+            Optimizer(PolynomialPotential V_);
             void add(double center_, int max_order_, double guess_, int label_);
             void set_integration_parameters(unsigned int npt_, double abs_, double rel_);
+            void set_integration_parameters(Integration method_, unsigned int npt_, double abs_, double rel_);
+            void set_minimizer(Minimizer method_);
+            void set_step_size(double step_size_);
+            void set_profiling(bool enable_);
             void optimize(size_t max_iter_, double stop_size_, bool verbose_);
+            void optimize_multistart(std::vector<std::vector<double>> guess_list_, size_t max_iter_, double stop_size_, bool verbose_);
+            double get_energy();
+            const Profile& get_profile();
             std::vector<Hermite> generate_basis_set(std::vector<int> max_order_list_);
 
             friend double minimization_target(const gsl_vector* v, void* pvoid);
+            friend void minimization_gradient(const gsl_vector* v, void* pvoid, gsl_vector* df);
+            friend void minimization_fdf(const gsl_vector* v, void* pvoid, double* f, gsl_vector* df);
     };
 
 }
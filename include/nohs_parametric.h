@@ -0,0 +1,52 @@
+#ifndef NOHS_PARAMETRIC_H
+#define NOHS_PARAMETRIC_H
+
+#include <vector>
+#include <memory>
+#include <armadillo>
+
+#include "nohs.h"
+#include "nohs_exceptions.h"
+
+namespace nohs{
+
+    // Solver for potentials written as a linear combination V(x) = sum_k lambda_k V_k(x). The overlap,
+    // the canonical orthogonalizer, the kinetic and the component matrices are computed once by prepare()
+    // so that every lambda point requires only a reduced-space combination and diagonalization.
+    class ParametricSolver{
+        private:
+            bool prepared;
+            int N, N_red, npt;
+            double abs, rel;
+            Assembly mode;
+            Integration integration;
+            std::vector<Hermite> BasisSet;
+            std::vector<double (*)(double, void*)> V;
+            std::vector<void*> parameters;
+            std::vector<int> polynomial;
+            std::vector<PolynomialPotential> polynomial_potential;
+            std::shared_ptr<utils::WorkspacePool> pool;
+            arma::mat Q_red, T_red;
+            std::vector<arma::mat> V_red;
+
+            void configure(Solver& system_);
+            arma::mat combine(const std::vector<double>& lambda_);
+
+        public:
+            ParametricSolver(std::vector<Hermite> BasisSet_);
+            void set_integration_parameters(unsigned int npt_, double abs_, double rel_);
+            void set_integration_parameters(Integration method_, unsigned int npt_, double abs_, double rel_);
+            void set_assembly_mode(Assembly mode_);
+            void set_workspace_pool(std::shared_ptr<utils::WorkspacePool> pool_);
+            void add(double (*V_)(double, void*), void* parameters_);
+            void add(PolynomialPotential V_);
+            void prepare(double threshold_);
+            int get_N_components();
+            int get_N_reduced();
+            arma::vec energies(std::vector<double> lambda_, int n_states_ = 0);
+            arma::mat sweep(std::vector<std::vector<double>> lambda_list_, int n_states_ = 0);
+    };
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef NOHS_PROPAGATOR_H
+#define NOHS_PROPAGATOR_H
+
+#include <vector>
+#include <armadillo>
+
+#include "nohs.h"
+#include "nohs_exceptions.h"
+
+namespace nohs{
+
+    // Time evolution of a wavepacket in the eigenbasis of a solved Solver. The initial state is projected once on the
+    // eigenstates, psi(x, t) = sum_n a_n exp(-i E_n t) phi_n(x), so that each time point only requires the phase factors
+    // and a product with the matrix of the eigenfunctions computed on a fixed grid.
+    class Propagator{
+        private:
+            bool init;
+            int N_states;
+            Solver* system;
+            arma::vec E, a_re, a_im;
+            std::vector<double> grid;
+            arma::mat B;
+
+            void project(const arma::vec& b_re_, const arma::vec& b_im_);
+            void phases(const std::vector<double>& t_list_, int start_, int count_, arma::mat& R_, arma::mat& I_);
+
+        public:
+            Propagator(Solver& system_, int n_states_ = 0);
+            void set_initial_state(double (*psi_)(double, void*), void* parameters_);
+            void set_initial_state(double (*psi_re_)(double, void*), double (*psi_im_)(double, void*), void* parameters_);
+            void set_initial_coefficients(std::vector<double> coefficients_);
+            void set_grid(std::vector<double> x_);
+            int get_N_states();
+            double norm();
+            arma::cx_vec amplitudes(double t_);
+            arma::cx_mat wavefunction(std::vector<double> t_list_);
+            arma::mat density(std::vector<double> t_list_);
+            arma::vec survival(std::vector<double> t_list_);
+            arma::vec expectation(const arma::mat& O_, std::vector<double> t_list_);
+    };
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include <string>
+#include <memory>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+#include "nohs_exceptions.h"
+#include "checkpoint.h"
+
+namespace nohs{
+    namespace checkpoint{
+
+        Hash::Hash() : value(14695981039346656037ULL) {}
+
+        void Hash::add(const void* data_, size_t size_){
+            const unsigned char* bytes = static_cast<const unsigned char*>(data_);
+            for(size_t i=0; i<size_; i++){
+                value ^= bytes[i];
+                value *= 1099511628211ULL;
+            }
+        }
+
+        uint64_t Hash::get() const {
+            return value;
+        }
+
+        std::shared_ptr<char> map_file(const std::string& path_, size_t& size_){
+            #if defined(__unix__) || defined(__APPLE__)
+                int fd = open(path_.c_str(), O_RDONLY);
+                if(fd < 0) throw exceptions::CheckpointError();
+                struct stat info;
+                if(fstat(fd, &info) != 0 || info.st_size <= 0){
+                    close(fd);
+                    throw exceptions::CheckpointError();
+                }
+                size_ = size_t(info.st_size);
+                void* address = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+                close(fd);                                                                          //The mapping remains valid after closing the descriptor
+                if(address == MAP_FAILED) throw exceptions::CheckpointError();
+                size_t length = size_;
+                return std::shared_ptr<char>(static_cast<char*>(address), [length](char* p){ munmap(p, length); });
+            #else
+                std::ifstream file(path_, std::ios::binary | std::ios::ate);
+                if(!file) throw exceptions::CheckpointError();
+                size_ = size_t(file.tellg());
+                std::shared_ptr<char> buffer(new char[size_], [](char* p){ delete[] p; });
+                file.seekg(0);
+                if(!file.read(buffer.get(), size_)) throw exceptions::CheckpointError();
+                return buffer;
+            #endif
+        }
+
+    }
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef NOHS_CHECKPOINT_H
+#define NOHS_CHECKPOINT_H
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace nohs{
+    namespace checkpoint{
+
+        const char magic[8] = {'N', 'O', 'H', 'S', 'C', 'K', 'P', 'T'};
+        const uint32_t version = 1;
+        const size_t alignment = 64;                                                                //Every section of the file starts at a multiple of alignment bytes
+
+        const uint32_t sparse_flag = 1;
+        const uint32_t reflection_flag = 2;
+
+        struct Header{
+            char magic[8];
+            uint32_t version, flags;
+            uint64_t hash;
+            uint64_t N, N_red, N_states, nnz_S, nnz_H;
+        };
+
+        inline size_t aligned(size_t size_){
+            return (size_ + alignment - 1)/alignment*alignment;
+        }
+
+        // 64-bit FNV-1a hash accumulated over the raw bytes of the added values
+        class Hash{
+            private:
+                uint64_t value;
+            public:
+                Hash();
+                void add(const void* data_, size_t size_);
+                template <typename T>
+                void add(T value_){
+                    add(&value_, sizeof(T));
+                }
+                uint64_t get() const;
+        };
+
+        // Maps the whole file path_ in memory with private copy-on-write pages (or reads it in a buffer where memory
+        // mapping is not available) and stores its size in size_. The memory is released with the last copy of the
+        // returned pointer. Raises an exceptions::CheckpointError if the file cannot be opened.
+        std::shared_ptr<char> map_file(const std::string& path_, size_t& size_);
+
+    }
+}
+
+#endif
\ No newline at end of file
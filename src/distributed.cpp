@@ -0,0 +1,98 @@
+#include <vector>
+#include <algorithm>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#include "distributed.h"
+
+namespace nohs{
+    namespace distributed{
+
+        bool active(){
+            #ifdef NOHS_MPI
+                int initialized = 0, finalized = 0;
+                MPI_Initialized(&initialized);
+                MPI_Finalized(&finalized);
+                if(initialized == 0 || finalized != 0) return false;
+                #ifdef _OPENMP
+                    if(omp_in_parallel() != 0) return false;
+                #endif
+                return size() > 1;
+            #else
+                return false;
+            #endif
+        }
+
+        int rank(){
+            int value = 0;
+            #ifdef NOHS_MPI
+                int initialized = 0;
+                MPI_Initialized(&initialized);
+                if(initialized != 0) MPI_Comm_rank(MPI_COMM_WORLD, &value);
+            #endif
+            return value;
+        }
+
+        int size(){
+            int value = 1;
+            #ifdef NOHS_MPI
+                int initialized = 0;
+                MPI_Initialized(&initialized);
+                if(initialized != 0) MPI_Comm_size(MPI_COMM_WORLD, &value);
+            #endif
+            return value;
+        }
+
+        Counter::Counter(long total_, long chunk_, bool shared_) : total(total_), chunk(std::max(1L, chunk_)), position(0), shared(shared_) {
+            #ifdef NOHS_MPI
+                base = nullptr;
+                if(shared == false) return;
+                MPI_Aint bytes = rank() == 0 ? MPI_Aint(sizeof(long)) : 0;
+                MPI_Win_allocate(bytes, sizeof(long), MPI_INFO_NULL, MPI_COMM_WORLD, &base, &window);
+                if(rank() == 0){
+                    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, window);
+                    *base = 0;
+                    MPI_Win_unlock(0, window);
+                }
+                MPI_Barrier(MPI_COMM_WORLD);
+                MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+            #endif
+        }
+
+        Counter::~Counter(){
+            #ifdef NOHS_MPI
+                if(shared == false) return;
+                MPI_Win_unlock_all(window);
+                MPI_Win_free(&window);
+            #endif
+        }
+
+        bool Counter::next(long& begin_, long& end_){
+            long begin = position;
+            #ifdef NOHS_MPI
+                if(shared == true){
+                    MPI_Fetch_and_op(&chunk, &begin, MPI_LONG, 0, 0, MPI_SUM, window);
+                    MPI_Win_flush(0, window);
+                }
+                else position += chunk;
+            #else
+                position += chunk;
+            #endif
+            if(begin >= total) return false;
+            begin_ = begin;
+            end_ = std::min(begin + chunk, total);
+            return true;
+        }
+
+        void sum(std::vector<double>& values_){
+            #ifdef NOHS_MPI
+                if(values_.empty() == false) MPI_Allreduce(MPI_IN_PLACE, values_.data(), int(values_.size()), MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+            #else
+                (void) values_;
+            #endif
+        }
+
+    }
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef NOHS_DISTRIBUTED_H
+#define NOHS_DISTRIBUTED_H
+
+#include <vector>
+
+#ifdef NOHS_MPI
+    #include <mpi.h>
+#endif
+
+namespace nohs{
+    namespace distributed{
+
+        // True if collective operations can be started on MPI_COMM_WORLD: the library has been built with MPI, the
+        // application has initialized (and not finalized) MPI, more than one process is running and the caller is not
+        // inside an OpenMP parallel region (e.g. the multistart optimization). Always false in builds without MPI.
+        bool active();
+        int rank();
+        int size();
+
+        // Dynamic distribution of the indices 0, ..., total_-1 in chunks of chunk_ indices: if shared_ is true (it must
+        // be the same on every process and requires active()) each process obtains its next chunk by an atomic
+        // fetch-and-add on a counter stored by the first process, and construction and destruction are collective.
+        // Otherwise, or without MPI, all the chunks are returned in order to the calling process.
+        class Counter{
+            private:
+                long total, chunk, position;
+                bool shared;
+                #ifdef NOHS_MPI
+                    long* base;
+                    MPI_Win window;
+                #endif
+            public:
+                Counter(long total_, long chunk_, bool shared_);
+                ~Counter();
+                bool next(long& begin_, long& end_);
+        };
+
+        // Sum of the values_ vectors of all the processes, stored in values_ by every process
+        void sum(std::vector<double>& values_);
+
+    }
+}
+
+#endif
\ No newline at end of file
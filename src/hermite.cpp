@@ -1,51 +1,137 @@
 #include <cmath>
+#include <algorithm>
 #include "nohs.h"
 #include "nohs_exceptions.h"
 
 namespace nohs{
 
-    static double hermite(double x, double alpha, int order){
-        if(order == 0) return sqrt(alpha/sqrt(M_PI))*exp(-0.5*pow(alpha*x, 2.));						    //0-th order Hermite function
-        else if(order == 1) return sqrt(alpha/(2.*sqrt(M_PI)))*2.*x*alpha*exp(-0.5*pow(alpha*x, 2.));		//1-st order hermite function
-        else{
-            double a = hermite(x, alpha, 0);												                //Set the (n-1)-th term to the value of the 0-th Hermite function
-            double b = hermite(x, alpha, 1);												                //Set the n-th term to the value of the 1-st Hermite function
-            for(int i=2; i<=order; i++){                                                                    //Iterate until the order-th function of the recursion series
-                double var = alpha*x*sqrt(2./i)*b - sqrt((i-1.)/i)*a;			                            //Apply the recursion relation to compute the (n+1)-th term
-                a = b;															                            //Set the current n-th term to the (n-1)-th	position
-                b = var;																                    //Copy the obtained result as the n-th value (needed for the next iteration)
-            }
-            return b;																	                    //Return the function value
+    static void hermite(double x, double alpha, int order, double& prev, double& cur, double& next){
+        double y = alpha*x;
+        prev = 0.;																		                    //Set the (n-1)-th term to zero (the -1-th function vanishes)
+        cur = std::sqrt(alpha/std::sqrt(M_PI))*std::exp(-0.5*y*y);						                    //Set the n-th term to the value of the 0-th Hermite function
+        next = std::sqrt(2.)*y*cur;														                    //Set the (n+1)-th term to the value of the 1-st Hermite function
+        for(int i=2; i<=order+1; i++){                                                                      //Iterate until the (order+1)-th function of the recursion series
+            double var = y*std::sqrt(2./i)*next - std::sqrt((i-1.)/i)*cur;			                        //Apply the recursion relation to compute the (n+2)-th term
+            prev = cur;																		                //Shift the n-th term to the (n-1)-th position
+            cur = next;																		                //Shift the (n+1)-th term to the n-th position
+            next = var;																		                //Copy the obtained result as the (n+1)-th value
         }
     }
 
-    Hermite::Hermite() : init(false), order(0), alpha(0.) {}
+    Hermite::Hermite() : init(false), order(0), alpha(0.), center(0.) {}
 
     Hermite::Hermite(int order_, double alpha_, double center_) : init(true), order(order_), alpha(alpha_), center(center_) {}
 
-    double Hermite::f(double x_) {
+    double Hermite::f(double x_) const {
+        if(init == false) throw exceptions::InitError();
+        return utils::hermite_function(order, alpha, center, x_);
+    }
+
+    double Hermite::d1f(double x_) const {
+        if(init == false) throw exceptions::InitError();
+        double prev, cur, next;
+        hermite(x_-center, alpha, order, prev, cur, next);
+        return alpha*(std::sqrt(order/2.)*prev - std::sqrt((order+1.)/2.)*next);
+    }
+
+    double Hermite::d2f(double x_) const {
         if(init == false) throw exceptions::InitError();
-        return hermite(x_-center, alpha, order);
+        double prev, cur, next;
+        double y = alpha*(x_-center);
+        hermite(x_-center, alpha, order, prev, cur, next);
+        return alpha*alpha*(y*y - (2.*order+1.))*cur;
     }
 
-    double Hermite::d1f(double x_) {
+    int Hermite::get_order() const {
         if(init == false) throw exceptions::InitError();
-        double y = x_-center;
-        double b = -std::sqrt((order+1.)/2.)*hermite(y, alpha, order+1);
-        if(order==0) return alpha*b;
-        else return alpha*(std::sqrt(order/2.)*hermite(y, alpha, order-1) + b);
+        return order;
     }
 
-    double Hermite::d2f(double x_) {
+    double Hermite::get_alpha() const {
         if(init == false) throw exceptions::InitError();
-        double y = x_-center;
-        double c = std::sqrt((order+2.)*(order+1.))*hermite(y, alpha, order+2);
-        double b = (2.*order+1.)*hermite(y, alpha, order);
-        if(order==0) return -0.5*std::pow(alpha, 2.)*((order+1.)*hermite(y, alpha, order) - c);
-        else if(order==1) return 0.5*std::pow(alpha, 2.)*(c-b);
-        else{
-            double a = std::sqrt(order*(order-1))*hermite(y, alpha, order-2);
-            return 0.5*std::pow(alpha, 2.)*(a-b+c);
+        return alpha;
+    }
+
+    double Hermite::get_center() const {
+        if(init == false) throw exceptions::InitError();
+        return center;
+    }
+
+    HermiteFamily::HermiteFamily() : init(false), max_order(0), alpha(0.), center(0.) {}
+
+    HermiteFamily::HermiteFamily(int max_order_, double alpha_, double center_) : init(true), max_order(max_order_), alpha(alpha_), center(center_) {}
+
+    void HermiteFamily::evaluate(double x_, double* f_, double* d1f_, double* d2f_) const {
+        evaluate(1, &x_, f_, d1f_, d2f_);
+    }
+
+    void HermiteFamily::evaluate(int npt_, const double* x_, double* f_, double* d1f_, double* d2f_) const {
+        if(init == false) throw exceptions::InitError();
+
+        // The points are processed in fixed-size blocks kept on the stack: for each order the inner
+        // loop runs over the points of the block and carries no dependency, so it can be vectorized.
+        const int block = 64;
+        double y[block], buffer[3][block];
+        double norm = std::sqrt(alpha/std::sqrt(M_PI));
+
+        for(int start=0; start<npt_; start+=block){
+            int m = std::min(block, npt_-start);
+            double* prev = buffer[0];
+            double* cur = buffer[1];
+            double* next = buffer[2];
+
+            #ifdef _OPENMP
+                #pragma omp simd
+            #endif
+            for(int k=0; k<m; k++){
+                y[k] = alpha*(x_[start+k]-center);
+                prev[k] = 0.;
+                cur[k] = norm*std::exp(-0.5*y[k]*y[k]);
+                next[k] = std::sqrt(2.)*y[k]*cur[k];
+            }
+
+            for(int n=0; n<=max_order; n++){
+                double* f = f_ + n*npt_ + start;
+                double a = alpha*std::sqrt(n/2.), b = alpha*std::sqrt((n+1.)/2.);
+                double c = std::sqrt(2./(n+2.)), d = std::sqrt((n+1.)/(n+2.));
+                double e = 2.*n+1., a2 = alpha*alpha;
+
+                #ifdef _OPENMP
+                    #pragma omp simd
+                #endif
+                for(int k=0; k<m; k++){
+                    f[k] = cur[k];
+                }
+                if(d1f_ != nullptr){
+                    double* d1f = d1f_ + n*npt_ + start;
+                    #ifdef _OPENMP
+                        #pragma omp simd
+                    #endif
+                    for(int k=0; k<m; k++){
+                        d1f[k] = a*prev[k] - b*next[k];
+                    }
+                }
+                if(d2f_ != nullptr){
+                    double* d2f = d2f_ + n*npt_ + start;
+                    #ifdef _OPENMP
+                        #pragma omp simd
+                    #endif
+                    for(int k=0; k<m; k++){
+                        d2f[k] = a2*(y[k]*y[k] - e)*cur[k];
+                    }
+                }
+
+                #ifdef _OPENMP
+                    #pragma omp simd
+                #endif
+                for(int k=0; k<m; k++){
+                    prev[k] = y[k]*c*next[k] - d*cur[k];                                                    //The (n+2)-th term overwrites the no longer needed (n-1)-th one
+                }
+                double* tmp = prev;
+                prev = cur;
+                cur = next;
+                next = tmp;
+            }
         }
     }
 
@@ -0,0 +1,192 @@
+#include <map>
+#include <cmath>
+#include <mutex>
+#include <utility>
+#include <armadillo>
+
+#include "nohs.h"
+#include "nohs_exceptions.h"
+#include "integrals.h"
+
+namespace nohs{
+    namespace integrals{
+
+        GaussHermiteTable::GaussHermiteTable() {}
+
+        GaussHermiteTable::GaussHermiteTable(int max_nodes_){
+            if(max_nodes_ < 1) throw exceptions::InvalidError();
+            for(int n=1; n<=max_nodes_; n++) add(n);
+        }
+
+        // Nodes and weights of the n nodes rule (Golub-Welsch), computed once for the whole process and then copied
+        // by every table requesting it
+        static void compute_rule(int n, arma::vec& t, arma::vec& w){
+            static std::map<int, std::pair<arma::vec, arma::vec>> rules;
+            static std::mutex lock;
+            std::lock_guard<std::mutex> guard(lock);
+            std::map<int, std::pair<arma::vec, arma::vec>>::const_iterator rule = rules.find(n);
+            if(rule != rules.end()){
+                t = rule->second.first;
+                w = rule->second.second;
+                return;
+            }
+
+            arma::mat J = arma::mat(n, n, arma::fill::zeros);                                       //Jacobi matrix of the Hermite polynomials recursion (Golub-Welsch)
+            for(int i=1; i<n; i++){
+                J(i, i-1) = std::sqrt(0.5*i);
+                J(i-1, i) = J(i, i-1);
+            }
+            t = arma::vec(n, arma::fill::zeros);
+            arma::mat Q = arma::mat(n, n, arma::fill::zeros);
+            arma::eig_sym(t, Q, J, "std");
+
+            w = arma::vec(n, arma::fill::zeros);
+            for(int k=0; k<n; k++){
+                double a = std::exp(-0.5*t(k)*t(k))/std::sqrt(std::sqrt(M_PI));                    //Unit-alpha Hermite functions computed at the node
+                double b = std::sqrt(2.)*t(k)*a;
+                double sum = a*a + (n > 1 ? b*b : 0.);
+                for(int i=2; i<n; i++){
+                    double var = t(k)*std::sqrt(2./i)*b - std::sqrt((i-1.)/i)*a;
+                    a = b;
+                    b = var;
+                    sum += b*b;
+                }
+                w(k) = 1./sum;                                                                      //Christoffel weight multiplied by exp(t^2)
+            }
+            rules[n] = std::make_pair(t, w);
+        }
+
+        void GaussHermiteTable::add(int n_nodes_){
+            if(n_nodes_ < 1) throw exceptions::InvalidError();
+            if(n_nodes_ <= max_nodes() && nodes[n_nodes_-1].n_elem != 0) return;
+            if(n_nodes_ > max_nodes()){
+                nodes.resize(n_nodes_);
+                weights.resize(n_nodes_);
+            }
+            compute_rule(n_nodes_, nodes[n_nodes_-1], weights[n_nodes_-1]);
+        }
+
+        int GaussHermiteTable::max_nodes() const {
+            return int(nodes.size());
+        }
+
+        const arma::vec& GaussHermiteTable::get_nodes(int n_) const {
+            if(n_ < 1 || n_ > max_nodes() || int(nodes[n_-1].n_elem) != n_) throw exceptions::BoundError();
+            return nodes[n_-1];
+        }
+
+        const arma::vec& GaussHermiteTable::get_weights(int n_) const {
+            if(n_ < 1 || n_ > max_nodes() || int(weights[n_-1].n_elem) != n_) throw exceptions::BoundError();
+            return weights[n_-1];
+        }
+
+        // The product of two Hermite functions is a polynomial of degree `degree` times the Gaussian
+        // exp(-p(x-X)^2): a Gauss-Hermite rule centered in X and scaled by 1/sqrt(p) with degree/2+1 nodes is exact.
+        template <typename Integrand>
+        static double product_nodes(const Hermite& a, const Hermite& b, int n_nodes, const GaussHermiteTable& table, Integrand integrand){
+            double a2 = std::pow(a.get_alpha(), 2.), b2 = std::pow(b.get_alpha(), 2.);
+            double p = 0.5*(a2 + b2);
+            double X = (a2*a.get_center() + b2*b.get_center())/(a2 + b2);
+            double scale = 1./std::sqrt(p);
+            const arma::vec& t = table.get_nodes(n_nodes);
+            const arma::vec& w = table.get_weights(n_nodes);
+            double result = 0.;
+            for(int k=0; k<int(t.n_elem); k++){
+                result += w(k)*integrand(X + scale*t(k));
+            }
+            return scale*result;
+        }
+
+        template <typename Integrand>
+        static double product_integral(const Hermite& a, const Hermite& b, int degree, const GaussHermiteTable& table, Integrand integrand){
+            return product_nodes(a, b, degree/2 + 1, table, integrand);
+        }
+
+        double overlap(const Hermite& a, const Hermite& b, const GaussHermiteTable& table){
+            int degree = a.get_order() + b.get_order();
+            return product_integral(a, b, degree, table, [&a, &b](double x){ return a.f(x)*b.f(x); });
+        }
+
+        double kinetic(const Hermite& a, const Hermite& b, const GaussHermiteTable& table){
+            int degree = a.get_order() + b.get_order() + 2;                                         //Integrated by parts: <a|-d2/dx2|b> = <a'|b'>
+            return product_integral(a, b, degree, table, [&a, &b](double x){ return a.d1f(x)*b.d1f(x); });
+        }
+
+        double potential(const Hermite& a, const Hermite& b, const PolynomialPotential& V, const GaussHermiteTable& table){
+            int degree = a.get_order() + b.get_order() + V.degree();
+            return product_integral(a, b, degree, table, [&a, &b, &V](double x){ return a.f(x)*V(x)*b.f(x); });
+        }
+
+
+        ProductBlock::ProductBlock() : n_nodes(0) {}
+
+        ProductBlock::ProductBlock(const Hermite& a_, int max_order_a_, const Hermite& b_, int max_order_b_, int n_nodes_, const GaussHermiteTable& table, bool derivatives_) : n_nodes(n_nodes_) {
+            double a2 = std::pow(a_.get_alpha(), 2.), b2 = std::pow(b_.get_alpha(), 2.);
+            double p = 0.5*(a2 + b2);
+            double X = (a2*a_.get_center() + b2*b_.get_center())/(a2 + b2);
+            double scale = 1./std::sqrt(p);
+            const arma::vec& t = table.get_nodes(n_nodes);
+            const arma::vec& weights = table.get_weights(n_nodes);
+            x.resize(n_nodes);
+            w.resize(n_nodes);
+            for(int k=0; k<n_nodes; k++){
+                x[k] = X + scale*t(k);
+                w[k] = scale*weights(k);
+            }
+
+            fa.resize((max_order_a_+1)*n_nodes);
+            fb.resize((max_order_b_+1)*n_nodes);
+            if(derivatives_ == true){
+                da.resize(fa.size());
+                db.resize(fb.size());
+            }
+            HermiteFamily(max_order_a_, a_.get_alpha(), a_.get_center()).evaluate(n_nodes, x.data(), fa.data(), derivatives_ == true ? da.data() : nullptr, nullptr);
+            HermiteFamily(max_order_b_, b_.get_alpha(), b_.get_center()).evaluate(n_nodes, x.data(), fb.data(), derivatives_ == true ? db.data() : nullptr, nullptr);
+        }
+
+        int ProductBlock::get_n_nodes() const {
+            return n_nodes;
+        }
+
+        const std::vector<double>& ProductBlock::get_points() const {
+            return x;
+        }
+
+        void ProductBlock::set_potential(const double* V_){
+            V.assign(V_, V_ + n_nodes);
+            for(int k=0; k<n_nodes; k++) V[k] *= w[k];
+        }
+
+        double ProductBlock::overlap(int order_a_, int order_b_) const {
+            const double* f = fa.data() + order_a_*n_nodes;
+            const double* g = fb.data() + order_b_*n_nodes;
+            double result = 0.;
+            for(int k=0; k<n_nodes; k++) result += w[k]*f[k]*g[k];
+            return result;
+        }
+
+        double ProductBlock::kinetic(int order_a_, int order_b_) const {
+            if(da.empty() == true) throw exceptions::InitError();
+            const double* f = da.data() + order_a_*n_nodes;
+            const double* g = db.data() + order_b_*n_nodes;
+            double result = 0.;
+            for(int k=0; k<n_nodes; k++) result += w[k]*f[k]*g[k];
+            return result;
+        }
+
+        double ProductBlock::potential(int order_a_, int order_b_) const {
+            if(V.empty() == true) throw exceptions::InitError();
+            const double* f = fa.data() + order_a_*n_nodes;
+            const double* g = fb.data() + order_b_*n_nodes;
+            double result = 0.;
+            for(int k=0; k<n_nodes; k++) result += V[k]*f[k]*g[k];
+            return result;
+        }
+
+
+        double product_rule(const Hermite& a, const Hermite& b, int n_nodes_, const GaussHermiteTable& table, double (*f)(double, void*), void* params){
+            return product_nodes(a, b, n_nodes_, table, [f, params](double x){ return f(x, params); });
+        }
+
+    }
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef NOHS_INTEGRALS_H
+#define NOHS_INTEGRALS_H
+
+#include <vector>
+#include <armadillo>
+
+#include "nohs.h"
+
+namespace nohs{
+    namespace integrals{
+
+        // Table of Gauss-Hermite rules with 1 to max_nodes_ nodes, or only with the node counts added later. Each rule
+        // is computed once for the whole process and shared by all the tables, so that adding the rules required by an
+        // assembly is cheap after the first one. The stored weights already include the exp(t^2) factor so that the
+        // rules can be applied directly to Gaussian-enveloped integrands. Rules must be added before the table is read
+        // by several threads.
+        class GaussHermiteTable{
+            private:
+                std::vector<arma::vec> nodes, weights;
+            public:
+                GaussHermiteTable();
+                GaussHermiteTable(int max_nodes_);
+                void add(int n_nodes_);
+                int max_nodes() const;
+                const arma::vec& get_nodes(int n_) const;
+                const arma::vec& get_weights(int n_) const;
+        };
+
+        // Values of the functions of two groups (each sharing alpha and center, up to the orders max_order_a_ and
+        // max_order_b_) on the n_nodes_ Gauss-Hermite rule centered on their product Gaussian. The rule is the same for
+        // all the pairs between the two groups: each function is computed once per node with a HermiteFamily, with
+        // its first derivative if derivatives_ is true, and each element becomes a sum over the nodes.
+        class ProductBlock{
+            private:
+                int n_nodes;
+                std::vector<double> x, w, fa, fb, da, db, V;
+            public:
+                ProductBlock();
+                ProductBlock(const Hermite& a_, int max_order_a_, const Hermite& b_, int max_order_b_, int n_nodes_, const GaussHermiteTable& table, bool derivatives_);
+                int get_n_nodes() const;
+                const std::vector<double>& get_points() const;
+                void set_potential(const double* V_);
+                double overlap(int order_a_, int order_b_) const;
+                double kinetic(int order_a_, int order_b_) const;
+                double potential(int order_a_, int order_b_) const;
+        };
+
+        // Exact integrals between pairs of Hermite functions with arbitrary alpha and center
+        double overlap(const Hermite& a, const Hermite& b, const GaussHermiteTable& table);
+        double kinetic(const Hermite& a, const Hermite& b, const GaussHermiteTable& table);
+        double potential(const Hermite& a, const Hermite& b, const PolynomialPotential& V, const GaussHermiteTable& table);
+
+        // Approximates the integral of f(x, params) (the whole integrand, Hermite functions included) with the n_nodes_
+        // Gauss-Hermite rule centered on the product Gaussian of the a and b functions. Exact for polynomial potentials
+        // of degree up to 2*n_nodes_-1-order_a-order_b.
+        double product_rule(const Hermite& a, const Hermite& b, int n_nodes_, const GaussHermiteTable& table, double (*f)(double, void*), void* params);
+
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#include <vector>
+#include <cstddef>
+
+#include "lapack.h"
+
+extern "C" void dsyevr_(const char* jobz, const char* range, const char* uplo, const int* n, double* a, const int* lda, const double* vl, const double* vu, const int* il, const int* iu, const double* abstol, int* m, double* w, double* z, const int* ldz, int* isuppz, double* work, const int* lwork, int* iwork, const int* liwork, int* info, size_t jobz_len, size_t range_len, size_t uplo_len);   //Hidden lengths of the character arguments (Fortran ABI)
+
+namespace nohs{
+    namespace lapack{
+
+        int lowest_eigenpairs(int n_, double* A_, int k_, double* E_, double* Z_){
+            int m = 0, info = 0, il = 1, iu = k_, lwork = -1, liwork = -1, iwork_size = 0;
+            double vl = 0., vu = 0., abstol = 0., work_size = 0.;
+            std::vector<int> isuppz(2*(k_ > 1 ? k_ : 1));
+            dsyevr_("V", "I", "L", &n_, A_, &n_, &vl, &vu, &il, &iu, &abstol, &m, E_, Z_, &n_, isuppz.data(), &work_size, &lwork, &iwork_size, &liwork, &info, 1, 1, 1);   //Workspace size query
+            if(info != 0) return info;
+            lwork = int(work_size);
+            liwork = iwork_size;
+            std::vector<double> work(lwork);
+            std::vector<int> iwork(liwork);
+            dsyevr_("V", "I", "L", &n_, A_, &n_, &vl, &vu, &il, &iu, &abstol, &m, E_, Z_, &n_, isuppz.data(), work.data(), &lwork, iwork.data(), &liwork, &info, 1, 1, 1);
+            return info;
+        }
+
+    }
+}
\ No newline at end of file
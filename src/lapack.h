@@ -0,0 +1,14 @@
+#ifndef NOHS_LAPACK_H
+#define NOHS_LAPACK_H
+
+namespace nohs{
+    namespace lapack{
+
+        // Computes the k_ lowest eigenpairs of the symmetric n_ x n_ matrix A_ (column-major, overwritten)
+        // using the LAPACK dsyevr routine. E_ must hold n_ values, Z_ must hold n_ x k_ values.
+        int lowest_eigenpairs(int n_, double* A_, int k_, double* E_, double* Z_);
+
+    }
+}
+
+#endif
\ No newline at end of file
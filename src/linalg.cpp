@@ -0,0 +1,211 @@
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <armadillo>
+
+#include "nohs.h"
+#include "nohs_exceptions.h"
+#include "linalg.h"
+#include "lapack.h"
+
+namespace nohs{
+    namespace linalg{
+
+        arma::mat orthogonalizer(const arma::mat& S_, double threshold_){
+
+            int N = int(S_.n_rows);
+            arma::mat Q = arma::mat(N, N, arma::fill::zeros);
+            arma::vec S_eval = arma::vec (N, arma::fill::zeros);
+            arma::eig_sym(S_eval, Q, S_, "std");
+
+            int stop_index = N-1;
+            while(stop_index > 0){
+                if(S_eval(stop_index-1) < threshold_){
+                    break;
+                }
+                stop_index--;
+            }
+
+            int N_red = N - stop_index;
+            arma::mat Q_red = arma::mat(N, N_red, arma::fill::zeros);
+
+            #ifdef _OPENMP
+                #pragma omp parallel for schedule(dynamic, 4)
+            #endif
+            for(int col=0; col<N_red; col++){
+                double factor = 1./std::sqrt(S_eval(stop_index + col));
+                for(int row=0; row<N; row++){
+                    Q_red(row, col) = Q(row, stop_index+col)*factor;
+                }
+            }
+
+            return Q_red;
+        }
+
+        void eigenpairs(arma::mat& H_red_, int n_states_, arma::vec& E_, arma::mat& C_red_){
+
+            int N_red = int(H_red_.n_rows);
+
+            #ifdef _OPENMP
+                #pragma omp parallel for schedule(dynamic, 4)
+            #endif
+            for(int row=0; row<N_red; row++){
+                for(int col=0; col<=row; col++){
+                    double average = 0.5*(H_red_(row, col) + H_red_(col, row));
+                    H_red_(row, col) = average;
+                    H_red_(col, row) = average;
+                }
+            }
+
+            if(n_states_ <= 0 || n_states_ >= N_red){
+                C_red_ = arma::mat(N_red, N_red, arma::fill::zeros);
+                E_ = arma::vec(N_red, arma::fill::zeros);
+                arma::eig_sym(E_, C_red_, H_red_, "std");
+            }
+            else{                                                                                   //Only the lowest n_states_ eigenpairs are computed and stored
+                arma::vec E_red = arma::vec(N_red, arma::fill::zeros);
+                C_red_ = arma::mat(N_red, n_states_, arma::fill::zeros);
+                int info = lapack::lowest_eigenpairs(N_red, H_red_.memptr(), n_states_, E_red.memptr(), C_red_.memptr());
+                if(info != 0) throw exceptions::EigenError();
+                E_ = arma::vec(n_states_, arma::fill::zeros);
+                for(int i=0; i<n_states_; i++) E_(i) = E_red(i);
+            }
+        }
+
+        int canonical_solve(const arma::mat& S_, const arma::mat& H_, double threshold_, int n_states_, arma::vec& E_, arma::mat& C_, double* timings_){
+
+            double start = timings_ != nullptr ? utils::wall_time() : 0.;
+            arma::mat Q_red = orthogonalizer(S_, threshold_);
+            int N = int(Q_red.n_rows), N_red = int(Q_red.n_cols);
+            double orthogonalized = timings_ != nullptr ? utils::wall_time() : 0.;
+
+            arma::mat H_red = arma::mat(N_red, N_red, arma::fill::zeros);
+            H_red = Q_red.t() * H_ * Q_red;
+            double transformed = timings_ != nullptr ? utils::wall_time() : 0.;
+
+            arma::mat C_red;
+            eigenpairs(H_red, n_states_, E_, C_red);
+            double diagonalized = timings_ != nullptr ? utils::wall_time() : 0.;
+            C_ = arma::mat(N, C_red.n_cols, arma::fill::zeros);
+            C_ = Q_red * C_red;
+
+            if(timings_ != nullptr){
+                timings_[0] += orthogonalized - start;
+                timings_[1] += (transformed - orthogonalized) + (utils::wall_time() - diagonalized);
+                timings_[2] += diagonalized - transformed;
+            }
+            return N_red;
+        }
+
+
+        int lobpcg(const arma::sp_mat& S_, const arma::sp_mat& H_, double threshold_, int n_states_, int max_iter_, double tol_, arma::vec& E_, arma::mat& C_){
+
+            int N = int(S_.n_rows);
+            int block = std::min(N, n_states_ + std::max(2, n_states_/2));                              //A few guard vectors speed up the convergence of the last states
+
+            std::vector<double> S_diag(N, 0.), H_diag(N, 0.);
+            double shift = 0.;
+            for(int i=0; i<N; i++){
+                S_diag[i] = S_(i, i);
+                H_diag[i] = H_(i, i);
+                if(i == 0 || H_diag[i]/S_diag[i] < shift) shift = H_diag[i]/S_diag[i];
+            }
+            shift -= std::max(1., std::fabs(shift));
+
+            if(N <= 3*block){                                                                       //Small problems are solved directly
+                arma::mat S = arma::mat(N, N, arma::fill::zeros);
+                arma::mat H = arma::mat(N, N, arma::fill::zeros);
+                for(int col=0; col<N; col++){
+                    for(int row=0; row<N; row++){
+                        S(row, col) = S_(row, col);
+                        H(row, col) = H_(row, col);
+                    }
+                }
+                canonical_solve(S, H, threshold_, n_states_, E_, C_);
+                return 0;
+            }
+
+            std::vector<int> order(N, 0);
+            for(int i=0; i<N; i++) order[i] = i;
+            std::sort(order.begin(), order.end(), [&](int a, int b){ return H_diag[a]/S_diag[a] < H_diag[b]/S_diag[b]; });
+
+            arma::mat X = arma::mat(N, block, arma::fill::zeros);
+            for(int col=0; col<block; col++) X(order[col], col) = 1./std::sqrt(S_diag[order[col]]);
+            arma::mat P;
+            arma::vec theta = arma::vec(block, arma::fill::zeros);
+            for(int col=0; col<block; col++) theta(col) = H_diag[order[col]]/S_diag[order[col]];
+            arma::vec theta_old = theta;
+            int stable_steps = 0;
+
+            for(int iter=1; iter<=max_iter_; iter++){
+
+                arma::mat HX = H_ * X;
+                arma::mat SX = S_ * X;
+
+                bool converged = true;
+                arma::mat W = arma::mat(N, block, arma::fill::zeros);
+                for(int col=0; col<block; col++){
+                    double norm = 0., H_norm = 0., S_norm = 0.;
+                    for(int row=0; row<N; row++){
+                        double residual = HX(row, col) - theta(col)*SX(row, col);
+                        W(row, col) = residual/(H_diag[row] - shift*S_diag[row]);
+                        norm += residual*residual;
+                        H_norm += HX(row, col)*HX(row, col);
+                        S_norm += SX(row, col)*SX(row, col);
+                    }
+                    if(col < n_states_ && std::sqrt(norm) > tol_*(std::sqrt(H_norm) + std::fabs(theta(col))*std::sqrt(S_norm))) converged = false;
+                }
+                // If the basis-set is almost linearly dependent the residuals cannot be reduced below the conditioning
+                // of S: the iterations are also stopped once the eigenvalues are stable over a few steps.
+                if(iter > 1){
+                    bool stable = true;
+                    for(int col=0; col<n_states_; col++){
+                        if(std::fabs(theta(col) - theta_old(col)) > 1e-3*tol_*std::max(1., std::fabs(theta(col)))) stable = false;
+                    }
+                    stable_steps = stable == true ? stable_steps + 1 : 0;
+                }
+                theta_old = theta;
+                if(converged == true || stable_steps >= 3){
+                    E_ = arma::vec(n_states_, arma::fill::zeros);
+                    C_ = arma::mat(N, n_states_, arma::fill::zeros);
+                    for(int col=0; col<n_states_; col++){
+                        E_(col) = theta(col);
+                        for(int row=0; row<N; row++) C_(row, col) = X(row, col);
+                    }
+                    return iter;
+                }
+
+                // Rayleigh-Ritz step on the subspace spanned by the current vectors X, the preconditioned residuals W
+                // and the previous search directions P. The columns of W and P are normalized so that the canonical
+                // orthogonalization only discards the genuinely redundant directions.
+                int N_P = int(P.n_cols), M = 2*block + N_P;
+                arma::mat Z = arma::mat(N, M, arma::fill::zeros);
+                for(int col=0; col<M; col++){
+                    const arma::mat& source = col < block ? X : (col < 2*block ? W : P);
+                    int source_col = col < block ? col : (col < 2*block ? col - block : col - 2*block);
+                    double norm = 0.;
+                    for(int row=0; row<N; row++) norm += source(row, source_col)*source(row, source_col);
+                    double factor = (col < block || norm == 0.) ? 1. : 1./std::sqrt(norm);
+                    for(int row=0; row<N; row++) Z(row, col) = factor*source(row, source_col);
+                }
+
+                arma::mat G_S = arma::mat(M, M, arma::fill::zeros);
+                arma::mat G_H = arma::mat(M, M, arma::fill::zeros);
+                G_S = Z.t() * (S_ * Z);
+                G_H = Z.t() * (H_ * Z);
+
+                arma::vec E_sub;
+                arma::mat C_sub;
+                canonical_solve(G_S, G_H, threshold_, block, E_sub, C_sub);
+                if(int(E_sub.n_elem) < block) throw exceptions::EigenError();
+
+                for(int col=0; col<block; col++) theta(col) = E_sub(col);
+                P = Z.cols(block, M-1) * C_sub.submat(block, 0, M-1, block-1);
+                X = Z * C_sub.cols(0, block-1);
+            }
+
+            throw exceptions::EigenError();
+        }
+
+    }
+}
\ No newline at end of file
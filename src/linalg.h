@@ -0,0 +1,33 @@
+#ifndef NOHS_LINALG_H
+#define NOHS_LINALG_H
+
+#include <armadillo>
+
+namespace nohs{
+    namespace linalg{
+
+        // Canonical orthogonalizer of the overlap matrix S_: the eigenvectors whose eigenvalues are above
+        // threshold_ are collected in the columns of the returned N x N_red matrix scaled by 1/sqrt(s).
+        arma::mat orthogonalizer(const arma::mat& S_, double threshold_);
+
+        // Eigenpairs of the symmetric reduced matrix H_red_ (symmetrized in place). If 0 < n_states_ < N_red
+        // only the lowest n_states_ pairs are computed, otherwise the full spectrum is returned.
+        void eigenpairs(arma::mat& H_red_, int n_states_, arma::vec& E_, arma::mat& C_red_);
+
+        // Solves the generalized eigenvalue problem H C = S C E in the canonical orthogonalized basis and
+        // returns the dimension of the reduced space. C_ is expressed in the original basis. If timings_ is not
+        // null the wall times of the orthogonalization, of the transformations and of the diagonalization are
+        // added to its first three elements.
+        int canonical_solve(const arma::mat& S_, const arma::mat& H_, double threshold_, int n_states_, arma::vec& E_, arma::mat& C_, double* timings_ = nullptr);
+
+        // Computes the n_states_ lowest eigenpairs of the sparse generalized problem H C = S C E by means of the
+        // locally optimal block preconditioned conjugate gradient method (LOBPCG) with a shifted Jacobi preconditioner.
+        // The Rayleigh-Ritz step is performed by canonical_solve with overlap threshold threshold_. Returns the number
+        // of iterations, an exceptions::EigenError is raised if the relative residuals are not below tol_ (or the
+        // eigenvalues are not stable) within max_iter_ steps.
+        int lobpcg(const arma::sp_mat& S_, const arma::sp_mat& H_, double threshold_, int n_states_, int max_iter_, double tol_, arma::vec& E_, arma::mat& C_);
+
+    }
+}
+
+#endif
\ No newline at end of file
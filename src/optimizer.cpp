@@ -1,9 +1,19 @@
 #include <cmath>
+#include <map>
+#include <algorithm>
+#include <exception>
+#include <tuple>
 #include <vector>
 #include <gsl/gsl_multimin.h>
+#include <gsl/gsl_blas.h>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
 
 #include "nohs_optimizer.h"
 #include "nohs.h"
+#include "linalg.h"
 
 template <typename T>
 static int find_index(std::vector<T> vector, T object){
@@ -27,29 +37,175 @@ namespace nohs{
 
     double minimization_target(const gsl_vector* v, void* pvoid){
         OptCarrier p = *(OptCarrier*) pvoid;
-        Optimizer* origin = p.opt_ptr;
+        return p.opt_ptr->ground_state(v, p.assignment, nullptr);
+    }
+
+    void minimization_gradient(const gsl_vector* v, void* pvoid, gsl_vector* df){
+        OptCarrier p = *(OptCarrier*) pvoid;
+        p.opt_ptr->ground_state(v, p.assignment, df);
+    }
 
-        int N = int(origin->max_order.size());
+    void minimization_fdf(const gsl_vector* v, void* pvoid, double* f, gsl_vector* df){
+        OptCarrier p = *(OptCarrier*) pvoid;
+        *f = p.opt_ptr->ground_state(v, p.assignment, df);
+    }
 
+    // Creates the persistent solver used during the optimization. Each group contributes max_order+extra_+1 functions
+    // starting from offset[i]: the functions are updated in place and the matrices are never reallocated.
+    void Optimizer::build_system(int extra_){
+        int N = int(max_order.size());
+        offset = std::vector<int>(N, 0);
         std::vector<Hermite> BasisSet;
         for(int i=0; i<N; i++){
-            double alpha = gsl_vector_get(v, p.assignment[i]);
-            for(int order=0; order<=origin->max_order[i]; order++){
-                Hermite function(order, alpha, origin->center[i]);
+            offset[i] = int(BasisSet.size());
+            for(int order=0; order<=max_order[i]+extra_; order++){
+                Hermite function(order, guess[i], center[i]);
                 BasisSet.push_back(function);
             }
         }
+        system.reset(polynomial ? new Solver(BasisSet, polynomial_potential) : new Solver(BasisSet, V, parameters));
+        system->set_integration_parameters(integration, npt, abs, rel);
+        system->set_workspace_pool(pool);
+        system->set_profiling(profiling);
+        system->S.zeros(BasisSet.size(), BasisSet.size());
+        system->H.zeros(BasisSet.size(), BasisSet.size());
+        extra_orders = extra_;
+        cache.clear();
+        evaluations = 0;
+    }
+
+    // Ground state energy of the basis-set encoded by v. If gradient is not null the derivatives of the energy with
+    // respect to the alpha parameters are also computed according to the Hellmann-Feynman theorem, dE/da = c'(dH - E dS)c.
+    // Since d(psi_n)/d(alpha) = [sqrt(n(n-1)) psi_(n-2) - sqrt((n+1)(n+2)) psi_(n+2)]/(2 alpha) the derivatives of S and H
+    // are obtained from the same assembly if the basis-set is augmented with the two following orders of each group.
+    double Optimizer::ground_state(const gsl_vector* v, const std::vector<int>& assignment, gsl_vector* gradient){
+
+        int N = int(max_order.size());
+        if(system == nullptr || (gradient != nullptr && extra_orders == 0)) build_system(gradient != nullptr || method == Minimizer::GRADIENT ? 2 : 0);
+        int extra = extra_orders;
+
+        // If the profiling is enabled each evaluation is recorded by the solver and then added to the optimizer report
+        double start = profiling == true ? utils::wall_time() : 0.;
+        double timings[3] = {0., 0., 0.};
+        double* timer = profiling == true ? timings : nullptr;
+        if(profiling == true) system->profile = Profile();
+
+        std::vector<double> alpha(N, 0.);
+        std::vector<int> index;
+        for(int i=0; i<N; i++){
+            alpha[i] = gsl_vector_get(v, assignment[i]);
+            for(int order=0; order<=max_order[i]+extra; order++){
+                system->BasisSet[offset[i]+order] = Hermite(order, alpha[i], center[i]);
+                if(order <= max_order[i]) index.push_back(offset[i] + order);
+            }
+        }
+
+        // The S and H blocks of each couple of groups depend only on the two alpha values: the blocks already
+        // computed are taken from the cache and only the missing ones are integrated. The cache retains only the
+        // blocks used by the last N_labels+1 evaluations (the vertices of the simplex) to bound its memory.
+        evaluations++;
+        arma::mat& S_full = system->S;
+        arma::mat& H_full = system->H;
+        std::vector<std::pair<int, int>> pairs;
+        std::vector<std::tuple<int, int, double, double>> missing;
+        for(int i=0; i<N; i++){
+            int size_i = max_order[i]+extra+1;
+            for(int j=i; j<N; j++){
+                int size_j = max_order[j]+extra+1;
+                std::tuple<int, int, double, double> key(i, j, alpha[i], alpha[j]);
+                auto block = cache.find(key);
+                if(block != cache.end()){
+                    block->second.last_use = evaluations;
+                    for(int col=0; col<size_j; col++){
+                        for(int row=0; row<size_i; row++){
+                            double S_value = block->second.S(row, col), H_value = block->second.H(row, col);
+                            S_full(offset[i]+row, offset[j]+col) = S_value; S_full(offset[j]+col, offset[i]+row) = S_value;
+                            H_full(offset[i]+row, offset[j]+col) = H_value; H_full(offset[j]+col, offset[i]+row) = H_value;
+                        }
+                    }
+                    continue;
+                }
+                for(int row=0; row<size_i; row++){
+                    for(int col=(i == j ? row : 0); col<size_j; col++){
+                        pairs.push_back(std::make_pair(offset[i]+row, offset[j]+col));
+                    }
+                }
+                missing.push_back(key);
+            }
+        }
+
+        if(pairs.empty() == false) system->integrate_pairs(pairs);
+        if(profiling == true) system->profile.assembly += utils::wall_time() - start;
+
+        for(int k=0; k<int(missing.size()); k++){
+            int i = std::get<0>(missing[k]), j = std::get<1>(missing[k]);
+            int size_i = max_order[i]+extra+1, size_j = max_order[j]+extra+1;
+            CachedBlock& block = cache[missing[k]];
+            block.last_use = evaluations;
+            block.S = S_full.submat(offset[i], offset[j], offset[i]+size_i-1, offset[j]+size_j-1);
+            block.H = H_full.submat(offset[i], offset[j], offset[i]+size_i-1, offset[j]+size_j-1);
+        }
+        for(auto block = cache.begin(); block != cache.end();){
+            if(evaluations - block->second.last_use > N_labels) block = cache.erase(block);
+            else ++block;
+        }
+
+        arma::vec E;
+        arma::mat C;
+        int M = int(index.size());
+        if(extra == 0){
+            linalg::canonical_solve(S_full, H_full, 1e-8, 1, E, C, timer);
+        }
+        else{
+            arma::mat S = arma::mat(M, M, arma::fill::zeros);
+            arma::mat H = arma::mat(M, M, arma::fill::zeros);
+            for(int col=0; col<M; col++){
+                for(int row=0; row<M; row++){
+                    S(row, col) = S_full(index[row], index[col]);
+                    H(row, col) = H_full(index[row], index[col]);
+                }
+            }
+            linalg::canonical_solve(S, H, 1e-8, 1, E, C, timer);
+        }
+        double energy = E(0);
 
-        Solver System(BasisSet, origin->V, origin->parameters);
-        System.set_integration_parameters(origin->npt, origin->abs, origin->rel);
-        System.solve(1e-8);
+        if(profiling == true){
+            Profile& step = system->profile;
+            step.solves = 1;
+            step.orthogonalization += timings[0];
+            step.transform += timings[1];
+            step.diagonalization += timings[2];
+            step.total = utils::wall_time() - start;
+            profile.accumulate(step);
+        }
+
+        if(gradient == nullptr) return energy;
+
+        arma::vec c = arma::vec(S_full.n_rows, arma::fill::zeros);
+        for(int k=0; k<M; k++) c(index[k]) = C(k, 0);
+        arma::vec r = arma::vec(S_full.n_rows, arma::fill::zeros);
+        r = (H_full - energy*S_full) * c;
+
+        gsl_vector_set_zero(gradient);
+        for(int i=0; i<N; i++){
+            double sum = 0.;
+            for(int n=0; n<=max_order[i]; n++){
+                double value = -std::sqrt((n+1.)*(n+2.))*r(offset[i]+n+2);
+                if(n >= 2) value += std::sqrt(n*(n-1.))*r(offset[i]+n-2);
+                sum += c(offset[i]+n)*value;
+            }
+            gsl_vector_set(gradient, assignment[i], gsl_vector_get(gradient, assignment[i]) + sum/alpha[i]);
+        }
 
-        return System.energy(0);
+        return energy;
     }
 
+    Optimizer::Optimizer(double (*V_)(double, void*), void* parameters_) : optimized(false), N_labels(0), npt(10000), abs(1e-10), rel(1e-10), step_size(0.5), method(Minimizer::SIMPLEX), integration(Integration::QAGI), optimized_energy(0.), V(V_), parameters(parameters_), polynomial(false), pool(std::make_shared<utils::WorkspacePool>()), extra_orders(0), evaluations(0), profiling(false) {}
 
-    
-    Optimizer::Optimizer(double (*V_)(double, void*), void* parameters_) : optimized(false), N_labels(0), npt(10000), abs(1e-10), rel(1e-10), V(V_), parameters(parameters_) {}
+    Optimizer::Optimizer(PolynomialPotential V_) : Optimizer(&PolynomialPotential::function, nullptr) {
+        polynomial = true;
+        polynomial_potential = V_;
+    }
 
     void Optimizer::add(double center_, int max_order_, double guess_, int label_){
         int idx = find_index<int>(label, label_);
@@ -59,20 +215,38 @@ namespace nohs{
         max_order.push_back(max_order_);
         guess.push_back(guess_);
         label.push_back(label_);
+        system.reset();
     }
 
     void Optimizer::set_integration_parameters(unsigned int npt_, double abs_, double rel_){
+        set_integration_parameters(integration, npt_, abs_, rel_);                                  //Checked against the current integration routine
+    }
+
+    void Optimizer::set_integration_parameters(Integration method_, unsigned int npt_, double abs_, double rel_){
+        if(method_ == Integration::GAUSS_HERMITE && (npt_ < 1 || npt_ > 200)) throw exceptions::InvalidError();
         npt = npt_; abs = abs_, rel = rel_;
+        integration = method_;
+        system.reset();
+    }
+
+    void Optimizer::set_minimizer(Minimizer method_){
+        method = method_;
+        system.reset();
+    }
+
+    void Optimizer::set_step_size(double step_size_){
+        if(step_size_ <= 0.) throw exceptions::InvalidError();
+        step_size = step_size_;
+    }
+
+    void Optimizer::set_profiling(bool enable_){
+        profiling = enable_;
+        profile = Profile();
+        system.reset();
     }
 
     void Optimizer::optimize(size_t max_iter_, double stop_size_, bool verbose_){
 
-        const gsl_multimin_fminimizer_type* T = gsl_multimin_fminimizer_nmsimplex2;
-        gsl_multimin_fminimizer* s = gsl_multimin_fminimizer_alloc (T, N_labels);
-        
-        gsl_vector* step = gsl_vector_alloc(N_labels);
-        gsl_vector_set_all (step, 0.5);
-        
         gsl_vector* x = gsl_vector_alloc(N_labels);
 
         int idx = 0;
@@ -88,47 +262,197 @@ namespace nohs{
             } 
         }
 
-        gsl_multimin_function target;
-        target.n = N_labels;
-        target.f = &minimization_target;
         OptCarrier data(this, assignment);
-        target.params = &data;
+        std::vector<double> result(N_labels, 0.);
+        build_system(method == Minimizer::GRADIENT ? 2 : 0);
+        profile = Profile();
         
-        gsl_multimin_fminimizer_set(s, &target, x, step);
+        if(method == Minimizer::GRADIENT){
 
-        size_t iter = 0;
-        int status;
-        double size;
+            const gsl_multimin_fdfminimizer_type* T = gsl_multimin_fdfminimizer_vector_bfgs2;
+            gsl_multimin_fdfminimizer* s = gsl_multimin_fdfminimizer_alloc(T, N_labels);
+
+            gsl_multimin_function_fdf target;
+            target.n = N_labels;
+            target.f = &minimization_target;
+            target.df = &minimization_gradient;
+            target.fdf = &minimization_fdf;
+            target.params = &data;
+
+            gsl_multimin_fdfminimizer_set(s, &target, x, step_size, 0.1);
+
+            size_t iter = 0;
+            int status;
+
+            do{
+                iter++;
+                status = gsl_multimin_fdfminimizer_iterate(s);
+                if (status) break;
+                status = gsl_multimin_test_gradient(s->gradient, stop_size_);
+                if(status == GSL_SUCCESS && verbose_==true){
+                    std::cout << "Optimization converged:" << std::endl;
+                    std::cout << "-> Iterations: " << iter << std::endl;
+                    std::cout << "-> Alpha values:" << std::endl;
+                    for(int i=0; i<N_labels; i++) std::cout << "        " << i << " -> " << gsl_vector_get(s->x, i) << std::endl;
+                    std::cout << "-> Function value: " << s->f << std::endl;
+                    std::cout << "-> Gradient norm: " << gsl_blas_dnrm2(s->gradient) << std::endl;
+                }
+            }while (status == GSL_CONTINUE && iter < max_iter_);
+
+            for(int i=0; i<N_labels; i++) result[i] = gsl_vector_get(s->x, i);
+            optimized_energy = s->f;
+            gsl_multimin_fdfminimizer_free(s);
+        }
+        else{
+
+            const gsl_multimin_fminimizer_type* T = gsl_multimin_fminimizer_nmsimplex2;
+            gsl_multimin_fminimizer* s = gsl_multimin_fminimizer_alloc (T, N_labels);
         
-        do{
-            iter++;
-            status = gsl_multimin_fminimizer_iterate(s);
-            if (status) break;
-            size = gsl_multimin_fminimizer_size(s);
-            status = gsl_multimin_test_size (size, stop_size_);
-            if(status == GSL_SUCCESS && verbose_==true){
-                std::cout << "Optimization converged:" << std::endl;
-                std::cout << "-> Iterations: " << iter << std::endl;
-                std::cout << "-> Alpha values:" << std::endl;
-                for(int i=0; i<N_labels; i++) std::cout << "        " << i << " -> " << gsl_vector_get(s->x, i) << std::endl;
-                std::cout << "-> Function value: " << s->fval << std::endl;
-                std::cout << "-> Simplex size: " << size << std::endl;
-            }
-        }while (status == GSL_CONTINUE && iter < max_iter_);
+            gsl_vector* step = gsl_vector_alloc(N_labels);
+            gsl_vector_set_all (step, step_size);
+
+            gsl_multimin_function target;
+            target.n = N_labels;
+            target.f = &minimization_target;
+            target.params = &data;
+        
+            gsl_multimin_fminimizer_set(s, &target, x, step);
+
+            size_t iter = 0;
+            int status;
+            double size;
+        
+            do{
+                iter++;
+                status = gsl_multimin_fminimizer_iterate(s);
+                if (status) break;
+                size = gsl_multimin_fminimizer_size(s);
+                status = gsl_multimin_test_size (size, stop_size_);
+                if(status == GSL_SUCCESS && verbose_==true){
+                    std::cout << "Optimization converged:" << std::endl;
+                    std::cout << "-> Iterations: " << iter << std::endl;
+                    std::cout << "-> Alpha values:" << std::endl;
+                    for(int i=0; i<N_labels; i++) std::cout << "        " << i << " -> " << gsl_vector_get(s->x, i) << std::endl;
+                    std::cout << "-> Function value: " << s->fval << std::endl;
+                    std::cout << "-> Simplex size: " << size << std::endl;
+                }
+            }while (status == GSL_CONTINUE && iter < max_iter_);
+
+            for(int i=0; i<N_labels; i++) result[i] = gsl_vector_get(s->x, i);
+            optimized_energy = s->fval;
+            gsl_vector_free(step);
+            gsl_multimin_fminimizer_free(s);
+        }
 
         optimized_alpha.clear();
         for(std::vector<int>::iterator ptr = assignment.begin(); ptr < assignment.end(); ptr++){
-            optimized_alpha.push_back(gsl_vector_get(s->x, *ptr));
+            optimized_alpha.push_back(result[*ptr]);
         }
         
         gsl_vector_free(x);
-        gsl_vector_free(step);
-        gsl_multimin_fminimizer_free(s);
 
         optimized = true;
 
     }
 
+    // Independent optimizations started from the guesses in guess_list_ are distributed among the available threads.
+    // Each one runs on its own Optimizer (and therefore on its own solver, cache and workspace pool) while the threads
+    // left are assigned to the inner Solver loops so that the two levels of parallelism do not oversubscribe the cores.
+    void Optimizer::optimize_multistart(std::vector<std::vector<double>> guess_list_, size_t max_iter_, double stop_size_, bool verbose_){
+
+        int N_starts = int(guess_list_.size());
+        if(N_starts == 0) throw exceptions::InvalidError();
+        for(int start=0; start<N_starts; start++){
+            if(int(guess_list_[start].size()) != N_labels) throw exceptions::InvalidError();
+        }
+
+        std::vector<int> skip, assignment(label.size(), -1);
+        for(int i=0, idx=0; i<int(label.size()); i++){
+            if(find_index(skip, label[i]) == -1){
+                skip.push_back(label[i]);
+                for(int j=0; j<int(label.size()); j++){
+                    if(label[j] == label[i]) assignment[j] = idx;
+                }
+                idx++;
+            }
+        }
+
+        std::vector<double> energy(N_starts, 0.);
+        std::vector<std::vector<double>> alpha(N_starts);
+        std::exception_ptr error = nullptr;
+        profile = Profile();
+
+        #ifdef _OPENMP
+            int outer = std::max(1, std::min(N_starts, omp_get_max_threads()));
+            int inner = std::max(1, omp_get_max_threads()/outer);
+            int max_levels = omp_get_max_active_levels();
+            if(inner > 1) omp_set_max_active_levels(std::max(max_levels, 2));
+            #pragma omp parallel for schedule(dynamic, 1) num_threads(outer)
+        #endif
+        for(int start=0; start<N_starts; start++){
+            #ifdef _OPENMP
+                omp_set_num_threads(inner);
+            #endif
+            try{
+                Optimizer worker = polynomial ? Optimizer(polynomial_potential) : Optimizer(V, parameters);
+                worker.N_labels = N_labels;
+                worker.npt = npt; worker.abs = abs; worker.rel = rel;
+                worker.integration = integration;
+                worker.step_size = step_size;
+                worker.method = method;
+                worker.profiling = profiling;
+                worker.max_order = max_order;
+                worker.label = label;
+                worker.center = center;
+                worker.guess = guess;
+                for(int i=0; i<int(label.size()); i++) worker.guess[i] = guess_list_[start][assignment[i]];
+                worker.optimize(max_iter_, stop_size_, false);
+                energy[start] = worker.optimized_energy;
+                alpha[start] = worker.optimized_alpha;
+                #ifdef _OPENMP
+                    #pragma omp critical
+                #endif
+                profile.accumulate(worker.profile);
+            }
+            catch(...){                                                                             //Exceptions cannot leave the parallel region
+                #ifdef _OPENMP
+                    #pragma omp critical
+                #endif
+                error = std::current_exception();
+            }
+        }
+
+        #ifdef _OPENMP
+            if(inner > 1) omp_set_max_active_levels(max_levels);
+        #endif
+        if(error != nullptr) std::rethrow_exception(error);
+
+        int best = 0;
+        for(int start=1; start<N_starts; start++){
+            if(energy[start] < energy[best]) best = start;
+        }
+
+        if(verbose_ == true){
+            std::cout << "Multi-start optimization completed:" << std::endl;
+            for(int start=0; start<N_starts; start++){
+                std::cout << "        " << start << " -> " << energy[start] << (start == best ? " (best)" : "") << std::endl;
+            }
+        }
+
+        optimized_alpha = alpha[best];
+        optimized_energy = energy[best];
+        optimized = true;
+    }
+
+    double Optimizer::get_energy(){
+        if(optimized == false) throw exceptions::OptimizeError();
+        return optimized_energy;
+    }
+
+    const Profile& Optimizer::get_profile(){
+        return profile;
+    }
+
     std::vector<Hermite> Optimizer::generate_basis_set(std::vector<int> max_order_list_){
         if(optimized == false) throw exceptions::OptimizeError();
         if(max_order_list_.size() != max_order.size()) throw exceptions::InvalidError();
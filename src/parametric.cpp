@@ -0,0 +1,128 @@
+#include <vector>
+#include <armadillo>
+
+#include "nohs_parametric.h"
+#include "nohs.h"
+#include "linalg.h"
+
+namespace nohs{
+
+    ParametricSolver::ParametricSolver(std::vector<Hermite> BasisSet_) : prepared(false), N(BasisSet_.size()), N_red(-1), npt(10000), abs(1e-10), rel(1e-10), mode(Assembly::QUADRATURE), integration(Integration::QAGI), BasisSet(BasisSet_), pool(std::make_shared<utils::WorkspacePool>()) {}
+
+    void ParametricSolver::set_integration_parameters(unsigned int npt_, double abs_, double rel_){
+        set_integration_parameters(integration, npt_, abs_, rel_);                                  //Checked against the current integration routine
+    }
+
+    void ParametricSolver::set_integration_parameters(Integration method_, unsigned int npt_, double abs_, double rel_){
+        if(method_ == Integration::GAUSS_HERMITE && (npt_ < 1 || npt_ > 200)) throw exceptions::InvalidError();
+        npt = npt_; abs = abs_, rel = rel_;
+        integration = method_;
+        prepared = false;
+    }
+
+    void ParametricSolver::set_assembly_mode(Assembly mode_){
+        mode = mode_;
+        prepared = false;
+    }
+
+    void ParametricSolver::set_workspace_pool(std::shared_ptr<utils::WorkspacePool> pool_){
+        if(pool_ == nullptr) throw exceptions::InvalidError();
+        pool = pool_;
+    }
+
+    void ParametricSolver::add(double (*V_)(double, void*), void* parameters_){
+        V.push_back(V_);
+        parameters.push_back(parameters_);
+        polynomial.push_back(0);
+        polynomial_potential.push_back(PolynomialPotential());
+        prepared = false;
+    }
+
+    void ParametricSolver::add(PolynomialPotential V_){
+        V.push_back(&PolynomialPotential::function);
+        parameters.push_back(nullptr);
+        polynomial.push_back(1);
+        polynomial_potential.push_back(V_);
+        prepared = false;
+    }
+
+    void ParametricSolver::configure(Solver& system_){
+        system_.set_integration_parameters(integration, npt, abs, rel);
+        system_.set_assembly_mode(mode);
+        system_.set_workspace_pool(pool);
+    }
+
+    void ParametricSolver::prepare(double threshold_){
+
+        Solver Kinetic(BasisSet, PolynomialPotential({0.}));                                    //A vanishing potential leaves the bare kinetic matrix in H
+        configure(Kinetic);
+        Kinetic.assemble();
+
+        Q_red = linalg::orthogonalizer(Kinetic.S, threshold_);
+        N_red = int(Q_red.n_cols);
+        T_red = Q_red.t() * Kinetic.H * Q_red;
+
+        V_red.clear();
+        for(int k=0; k<int(V.size()); k++){
+            Solver Component = polynomial[k] == 1 ? Solver(BasisSet, polynomial_potential[k]) : Solver(BasisSet, V[k], parameters[k]);
+            configure(Component);
+            Component.kinetic = false;
+            Component.assemble();
+            V_red.push_back(Q_red.t() * Component.H * Q_red);
+        }
+
+        prepared = true;
+    }
+
+    int ParametricSolver::get_N_components(){
+        return int(V.size());
+    }
+
+    int ParametricSolver::get_N_reduced(){
+        if(prepared == false) throw exceptions::PrepareError();
+        return N_red;
+    }
+
+    arma::mat ParametricSolver::combine(const std::vector<double>& lambda_){
+        if(prepared == false) throw exceptions::PrepareError();
+        if(lambda_.size() != V_red.size()) throw exceptions::InvalidError();
+        arma::mat H_red = T_red;
+        for(int k=0; k<int(V_red.size()); k++){
+            if(lambda_[k] != 0.) H_red += lambda_[k]*V_red[k];
+        }
+        return H_red;
+    }
+
+    arma::vec ParametricSolver::energies(std::vector<double> lambda_, int n_states_){
+        arma::mat H_red = combine(lambda_);
+        arma::vec E;
+        arma::mat C_red;
+        linalg::eigenpairs(H_red, n_states_, E, C_red);
+        return E;
+    }
+
+    arma::mat ParametricSolver::sweep(std::vector<std::vector<double>> lambda_list_, int n_states_){
+        if(prepared == false) throw exceptions::PrepareError();
+        for(int p=0; p<int(lambda_list_.size()); p++){
+            if(lambda_list_[p].size() != V_red.size()) throw exceptions::InvalidError();
+        }
+
+        int N_points = int(lambda_list_.size());
+        int N_cols = (n_states_ <= 0 || n_states_ >= N_red) ? N_red : n_states_;
+        arma::mat result = arma::mat(N_points, N_cols, arma::fill::zeros);
+
+        #ifdef _OPENMP
+            #pragma omp parallel for schedule(dynamic, 1)
+        #endif
+        for(int p=0; p<N_points; p++){                                                              //Every lambda point is independent
+            arma::mat H_red = combine(lambda_list_[p]);
+            arma::vec E;
+            arma::mat C_red;
+            linalg::eigenpairs(H_red, n_states_, E, C_red);
+            for(int i=0; i<N_cols; i++) result(p, i) = E(i);
+        }
+
+        return result;
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include <vector>
+
+#include "nohs.h"
+#include "nohs_exceptions.h"
+
+namespace nohs{
+
+    PolynomialPotential::PolynomialPotential() {}
+
+    PolynomialPotential::PolynomialPotential(std::vector<double> coefficients_) : coefficients(coefficients_) {
+        if(coefficients.size() == 0) throw exceptions::InvalidError();
+    }
+
+    int PolynomialPotential::degree() const {
+        return int(coefficients.size()) - 1;
+    }
+
+    double PolynomialPotential::coefficient(int power_) const {
+        if(power_ < 0 || power_ >= int(coefficients.size())) throw exceptions::BoundError();
+        return coefficients[power_];
+    }
+
+    double PolynomialPotential::operator()(double x_) const {
+        double value = 0.;
+        for(int k=int(coefficients.size())-1; k>=0; k--){                                          //Horner scheme
+            value = value*x_ + coefficients[k];
+        }
+        return value;
+    }
+
+    double PolynomialPotential::function(double x_, void* pvoid){
+        return (*static_cast<const PolynomialPotential*>(pvoid))(x_);
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include <chrono>
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+#include "nohs.h"
+
+namespace nohs{
+
+    namespace utils{
+
+        double wall_time(){
+            std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now().time_since_epoch();
+            return std::chrono::duration<double>(elapsed).count();
+        }
+
+    }
+
+    Profile::Profile() : solves(0), pairs(0), integrand_evaluations(0), potential_evaluations(0), subintervals(0), failures(0), max_error(0.), assembly(0.), symmetrization(0.), orthogonalization(0.), transform(0.), diagonalization(0.), total(0.) {}
+
+    void Profile::accumulate(const Profile& other_){
+        solves += other_.solves; pairs += other_.pairs;
+        integrand_evaluations += other_.integrand_evaluations; potential_evaluations += other_.potential_evaluations;
+        subintervals += other_.subintervals; failures += other_.failures;
+        max_error = std::max(max_error, other_.max_error);
+        assembly += other_.assembly; symmetrization += other_.symmetrization; orthogonalization += other_.orthogonalization;
+        transform += other_.transform; diagonalization += other_.diagonalization; total += other_.total;
+        if(thread_busy.size() < other_.thread_busy.size()) thread_busy.resize(other_.thread_busy.size(), 0.);
+        if(thread_pairs.size() < other_.thread_pairs.size()) thread_pairs.resize(other_.thread_pairs.size(), 0);
+        for(size_t t=0; t<other_.thread_busy.size(); t++) thread_busy[t] += other_.thread_busy[t];
+        for(size_t t=0; t<other_.thread_pairs.size(); t++) thread_pairs[t] += other_.thread_pairs[t];
+    }
+
+    std::string Profile::json() const {
+        std::ostringstream out;
+        out.precision(10);
+        out << "{\"solves\": " << solves << ", \"pairs\": " << pairs;
+        out << ", \"integrand_evaluations\": " << integrand_evaluations << ", \"potential_evaluations\": " << potential_evaluations;
+        out << ", \"subintervals\": " << subintervals << ", \"failures\": " << failures << ", \"max_error\": " << max_error;
+        out << ", \"time\": {\"assembly\": " << assembly << ", \"symmetrization\": " << symmetrization;
+        out << ", \"orthogonalization\": " << orthogonalization << ", \"transform\": " << transform;
+        out << ", \"diagonalization\": " << diagonalization << ", \"total\": " << total << "}";
+        out << ", \"thread_busy\": [";
+        for(size_t t=0; t<thread_busy.size(); t++) out << (t == 0 ? "" : ", ") << thread_busy[t];
+        out << "], \"thread_pairs\": [";
+        for(size_t t=0; t<thread_pairs.size(); t++) out << (t == 0 ? "" : ", ") << thread_pairs[t];
+        out << "]}";
+        return out.str();
+    }
+
+}
\ No newline at end of file
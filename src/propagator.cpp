@@ -0,0 +1,194 @@
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <armadillo>
+
+#include "nohs_propagator.h"
+#include "nohs.h"
+
+namespace nohs{
+
+    Propagator::Propagator(Solver& system_, int n_states_) : init(false), N_states(0), system(&system_) {
+        if(system_.solved == false) throw exceptions::SolverError();
+        N_states = (n_states_ <= 0 || n_states_ > system_.N_states) ? system_.N_states : n_states_;
+        E = arma::vec(N_states, arma::fill::zeros);
+        for(int n=0; n<N_states; n++) E(n) = system_.E(n);
+    }
+
+    // Amplitudes of the state with overlaps <chi_i|psi> (b_re_ + i b_im_) with the basis functions: a_n = sum_i C_in b_i
+    void Propagator::project(const arma::vec& b_re_, const arma::vec& b_im_){
+        arma::mat C_sub = arma::mat(system->N, N_states, arma::fill::zeros);
+        for(int n=0; n<N_states; n++){
+            for(int i=0; i<system->N; i++) C_sub(i, n) = system->C(i, n);
+        }
+        a_re = C_sub.t() * b_re_;
+        a_im = C_sub.t() * b_im_;
+        init = true;
+    }
+
+    void Propagator::set_initial_state(double (*psi_)(double, void*), void* parameters_){
+        set_initial_state(psi_, nullptr, parameters_);
+    }
+
+    // The overlaps with the basis functions are computed with the trapezoidal rule on the uniform grid used by the
+    // Assembly::GRID mode of the solver, which converges exponentially for smooth initial states.
+    void Propagator::set_initial_state(double (*psi_re_)(double, void*), double (*psi_im_)(double, void*), void* parameters_){
+        if(psi_re_ == nullptr) throw exceptions::InvalidError();
+        int N = system->N;
+        double step;
+        std::vector<double> x = system->basis_grid(step);
+        int G = int(x.size());
+
+        arma::vec b_re = arma::vec(N, arma::fill::zeros), b_im = arma::vec(N, arma::fill::zeros);
+        const int chunk = 256;
+        for(int start=0; start<G; start+=chunk){
+            int m = std::min(chunk, G-start);
+            arma::mat F = arma::mat(m, N, arma::fill::zeros);
+            system->evaluate_basis(m, x.data()+start, m, F.memptr(), nullptr, nullptr);
+            arma::vec w_re = arma::vec(m, arma::fill::zeros), w_im = arma::vec(m, arma::fill::zeros);
+            for(int k=0; k<m; k++){
+                w_re(k) = step*psi_re_(x[start+k], parameters_);
+                if(psi_im_ != nullptr) w_im(k) = step*psi_im_(x[start+k], parameters_);
+            }
+            b_re += F.t() * w_re;
+            if(psi_im_ != nullptr) b_im += F.t() * w_im;
+        }
+        project(b_re, b_im);
+    }
+
+    void Propagator::set_initial_coefficients(std::vector<double> coefficients_){
+        int N = system->N;
+        if(int(coefficients_.size()) != N) throw exceptions::InvalidError();
+        arma::vec d = arma::vec(coefficients_);
+        arma::vec b_re = system->storage == Storage::SPARSE ? arma::vec(system->S_sparse * d) : arma::vec(system->S * d);
+        project(b_re, arma::vec(N, arma::fill::zeros));
+    }
+
+    void Propagator::set_grid(std::vector<double> x_){
+        std::vector<int> index_list(N_states);
+        for(int n=0; n<N_states; n++) index_list[n] = n;
+        B = system->psi_grid(index_list, x_);
+        grid = x_;
+    }
+
+    int Propagator::get_N_states(){
+        return N_states;
+    }
+
+    double Propagator::norm(){
+        if(init == false) throw exceptions::InitError();
+        return arma::dot(a_re, a_re) + arma::dot(a_im, a_im);
+    }
+
+    // Real and imaginary parts of a_n exp(-i E_n t) for the count_ time points starting from start_ (one per column)
+    void Propagator::phases(const std::vector<double>& t_list_, int start_, int count_, arma::mat& R_, arma::mat& I_){
+        R_ = arma::mat(N_states, count_, arma::fill::zeros);
+        I_ = arma::mat(N_states, count_, arma::fill::zeros);
+        for(int j=0; j<count_; j++){
+            for(int n=0; n<N_states; n++){
+                double c = std::cos(E(n)*t_list_[start_+j]), s = std::sin(E(n)*t_list_[start_+j]);
+                R_(n, j) = a_re(n)*c + a_im(n)*s;
+                I_(n, j) = a_im(n)*c - a_re(n)*s;
+            }
+        }
+    }
+
+    arma::cx_vec Propagator::amplitudes(double t_){
+        if(init == false) throw exceptions::InitError();
+        arma::mat R, I;
+        phases(std::vector<double>(1, t_), 0, 1, R, I);
+        arma::cx_vec result = arma::cx_vec(N_states, arma::fill::zeros);
+        for(int n=0; n<N_states; n++) result(n) = arma::cx_double(R(n, 0), I(n, 0));
+        return result;
+    }
+
+    // The time points are processed in blocks distributed among the available threads: each block requires
+    // two products of the matrix of the eigenfunctions on the grid with the matrices of the phase factors.
+    arma::cx_mat Propagator::wavefunction(std::vector<double> t_list_){
+        if(init == false || grid.empty() == true) throw exceptions::InitError();
+        int G = int(grid.size()), T = int(t_list_.size());
+        arma::cx_mat result = arma::cx_mat(G, T, arma::fill::zeros);
+        const int block = 64;
+        #ifdef _OPENMP
+            #pragma omp parallel for schedule(dynamic, 1)
+        #endif
+        for(int start=0; start<T; start+=block){
+            int m = std::min(block, T-start);
+            arma::mat R, I;
+            phases(t_list_, start, m, R, I);
+            arma::mat P_re = B * R, P_im = B * I;
+            for(int j=0; j<m; j++){
+                for(int k=0; k<G; k++) result(k, start+j) = arma::cx_double(P_re(k, j), P_im(k, j));
+            }
+        }
+        return result;
+    }
+
+    arma::mat Propagator::density(std::vector<double> t_list_){
+        if(init == false || grid.empty() == true) throw exceptions::InitError();
+        int G = int(grid.size()), T = int(t_list_.size());
+        arma::mat result = arma::mat(G, T, arma::fill::zeros);
+        const int block = 64;
+        #ifdef _OPENMP
+            #pragma omp parallel for schedule(dynamic, 1)
+        #endif
+        for(int start=0; start<T; start+=block){
+            int m = std::min(block, T-start);
+            arma::mat R, I;
+            phases(t_list_, start, m, R, I);
+            arma::mat P_re = B * R, P_im = B * I;
+            for(int j=0; j<m; j++){
+                for(int k=0; k<G; k++) result(k, start+j) = P_re(k, j)*P_re(k, j) + P_im(k, j)*P_im(k, j);
+            }
+        }
+        return result;
+    }
+
+    // |<psi(0)|psi(t)>|^2/<psi(0)|psi(0)>^2 with <psi(0)|psi(t)> = sum_n |a_n|^2 exp(-i E_n t)
+    arma::vec Propagator::survival(std::vector<double> t_list_){
+        double weight = norm();
+        if(weight == 0.) throw exceptions::InvalidError();
+        int T = int(t_list_.size());
+        arma::vec result = arma::vec(T, arma::fill::zeros);
+        #ifdef _OPENMP
+            #pragma omp parallel for schedule(static)
+        #endif
+        for(int j=0; j<T; j++){
+            double re = 0., im = 0.;
+            for(int n=0; n<N_states; n++){
+                double p = a_re(n)*a_re(n) + a_im(n)*a_im(n);
+                re += p*std::cos(E(n)*t_list_[j]);
+                im -= p*std::sin(E(n)*t_list_[j]);
+            }
+            result(j) = (re*re + im*im)/(weight*weight);
+        }
+        return result;
+    }
+
+    // <psi(t)|O|psi(t)>/<psi(t)|psi(t)> for the symmetric matrix O_ of an operator between the propagated eigenstates
+    // (e.g. the one returned by Solver::observable for the states 0, ..., N_states-1)
+    arma::vec Propagator::expectation(const arma::mat& O_, std::vector<double> t_list_){
+        double weight = norm();
+        if(weight == 0.) throw exceptions::InvalidError();
+        if(int(O_.n_rows) != N_states || int(O_.n_cols) != N_states) throw exceptions::InvalidError();
+        int T = int(t_list_.size());
+        arma::vec result = arma::vec(T, arma::fill::zeros);
+        const int block = 64;
+        #ifdef _OPENMP
+            #pragma omp parallel for schedule(dynamic, 1)
+        #endif
+        for(int start=0; start<T; start+=block){
+            int m = std::min(block, T-start);
+            arma::mat R, I;
+            phases(t_list_, start, m, R, I);
+            arma::mat OR = O_ * R, OI = O_ * I;
+            for(int j=0; j<m; j++){
+                double value = 0.;
+                for(int n=0; n<N_states; n++) value += R(n, j)*OR(n, j) + I(n, j)*OI(n, j);
+                result(start+j) = value/weight;
+            }
+        }
+        return result;
+    }
+
+}
\ No newline at end of file
@@ -1,4 +1,10 @@
 #include <cmath>
+#include <vector>
+#include <utility>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
 #include <armadillo>
 #include <gsl/gsl_integration.h>
 #include <gsl/gsl_errno.h>
@@ -9,31 +15,117 @@
 
 #include "nohs.h"
 #include "nohs_exceptions.h"
+#include "integrals.h"
+#include "linalg.h"
+#include "checkpoint.h"
+#include "distributed.h"
 
 namespace nohs{
 
-    static double QAGI_integrator(double (*f)(double, void*), void * pvoid, int npt, double abs, double rel){
+    // Records the outcome of an adaptive integration: the routine applies its rule of `points` points once on the
+    // whole interval and then twice for each bisection, so that the number of evaluations follows from the number
+    // of subintervals left in the workspace.
+    static void record_quadrature(Profile* profile, const gsl_integration_workspace* w, long points, double error, int status){
+        if(profile == nullptr) return;
+        long evaluations = points*(2*long(w->size) - 1);
+        profile->integrand_evaluations += evaluations;
+        profile->potential_evaluations += evaluations;
+        profile->subintervals += long(w->size);
+        profile->max_error = std::max(profile->max_error, error);
+        if(status != GSL_SUCCESS) profile->failures++;
+    }
+
+    static double QAGI_integrator(double (*f)(double, void*), void * pvoid, gsl_integration_workspace* w, int npt, double abs, double rel, Profile* profile){
+        double result, error;
+        gsl_function integrand;
+        integrand.function = f;
+        integrand.params = pvoid;
+        int status = gsl_integration_qagi(&integrand, abs, rel, npt, w, &result, &error);
+        record_quadrature(profile, w, 2*15, error, status);                                        //The 15 points rule is applied to f(x) + f(-x)
+        return result;
+    }
+
+    static double QAG_integrator(double (*f)(double, void*), void * pvoid, gsl_integration_workspace* w, int npt, double abs, double rel, double lower, double upper, Profile* profile){
         double result, error;
         gsl_function integrand;
         integrand.function = f;
         integrand.params = pvoid;
-        gsl_integration_workspace* w = gsl_integration_workspace_alloc(npt);
-        gsl_integration_qagi(&integrand, abs, rel, npt, w, &result, &error);
-        gsl_integration_workspace_free(w);
+        int status = gsl_integration_qag(&integrand, lower, upper, abs, rel, npt, GSL_INTEG_GAUSS21, w, &result, &error);
+        record_quadrature(profile, w, 21, error, status);
         return result;
     }
 
-    double Solver::overlap_integrand(int row, int col, double x){
-        return BasisSet[row].f(x)*BasisSet[col].f(x);
+    // Finite integration window of a pair of functions: each function is negligible outside its classical region,
+    // sqrt(2n+1)/alpha around the center, extended by margin/alpha. Returns false if the two windows do not intersect.
+    static bool integration_window(const Hermite& a, const Hermite& b, double margin, double& lower, double& upper){
+        double r_a = (std::sqrt(2.*a.get_order() + 1.) + margin)/a.get_alpha();
+        double r_b = (std::sqrt(2.*b.get_order() + 1.) + margin)/b.get_alpha();
+        lower = std::max(a.get_center() - r_a, b.get_center() - r_b);
+        upper = std::min(a.get_center() + r_a, b.get_center() + r_b);
+        return lower < upper;
+    }
+
+    static int thread_id(){
+        #ifdef _OPENMP
+            return omp_get_thread_num();
+        #else
+            return 0;
+        #endif
     }
 
-    double Solver::hamiltonian_integrand(int row, int col, double x){
-        return BasisSet[row].f(x)*(-BasisSet[col].d2f(x) + V(x, parameters)*BasisSet[col].f(x));
+    static int max_threads(){
+        #ifdef _OPENMP
+            return omp_get_max_threads();
+        #else
+            return 1;
+        #endif
     }
 
-    Solver::Solver(unsigned int N_, double (*V_)(double, void*), void* parameters_) : solved(false), N(N_), N_red(-1), npt(10000), abs(1e-10), rel(1e-10), V(V_), parameters(parameters_) {
-        H = arma::mat(N, N, arma::fill::zeros);
-        S = arma::mat(N, N, arma::fill::zeros);
+    // Estimate of the magnitude of the matrix elements between two Hermite functions. Outside its classical region,
+    // sqrt(2n+1)/alpha around the center, each function decays as its Gaussian envelope: the estimate is the product
+    // of the two envelopes at the optimal point between the edges of the two classical regions.
+    static double screening_estimate(double alpha_a, double center_a, int order_a, double alpha_b, double center_b, int order_b){
+        double gap = std::fabs(center_a - center_b) - std::sqrt(2.*order_a + 1.)/alpha_a - std::sqrt(2.*order_b + 1.)/alpha_b;
+        if(gap <= 0.) return 1.;
+        double a2 = alpha_a*alpha_a, b2 = alpha_b*alpha_b;
+        return std::exp(-0.5*a2*b2*gap*gap/(a2 + b2));
+    }
+
+    static double screening_estimate(const Hermite& a, const Hermite& b){
+        return screening_estimate(a.get_alpha(), a.get_center(), a.get_order(), b.get_alpha(), b.get_center(), b.get_order());
+    }
+
+    static void finish_profile(Profile& profile, double start, const double* timings){
+        profile.solves = 1;
+        profile.orthogonalization += timings[0];
+        profile.transform += timings[1];
+        profile.diagonalization += timings[2];
+        profile.total = utils::wall_time() - start;
+    }
+
+    double Solver::potential(double x_){
+        if(polynomial == true) return polynomial_potential(x_);
+        return V(x_, parameters);
+    }
+
+    void Solver::potential(int npt_, const double* x_, double* V_){
+        for(int k=0; k<npt_; k++) V_[k] = potential(x_[k]);
+    }
+
+    // Integrand of the adaptive routines for the function-pointer potential, called directly without the virtual
+    // potential (the polynomial potentials never reach the adaptive routines)
+    double Solver::function_integrand(double x, void* pvoid){
+        const utils::PairCarrier& data = *static_cast<const utils::PairCarrier*>(pvoid);
+        double a = utils::hermite_function(data.order_a, data.alpha_a, data.center_a, x);
+        double b = utils::hermite_function(data.order_b, data.alpha_b, data.center_b, x);
+        return a*data.cpt->V(x, data.cpt->parameters)*b;
+    }
+
+    utils::PairIntegrand Solver::pair_integrand(){
+        return &Solver::function_integrand;
+    }
+
+    Solver::Solver(unsigned int N_, double (*V_)(double, void*), void* parameters_) : solved(false), N(N_), N_assembled(0), N_red(-1), N_states(-1), npt(10000), abs(1e-10), rel(1e-10), margin(6.), density(1.), mode(Assembly::QUADRATURE), integration(Integration::QAGI), reflection(false), kinetic(true), storage(Storage::DENSE), screening(0.), sparse_max_iter(1000), sparse_tol(1e-8), V(V_), parameters(parameters_), polynomial(false), pool(std::make_shared<utils::WorkspacePool>()), profiling(false), distribute(true), reuse(false) {
         BasisSet.reserve(N);
     }
 
@@ -41,28 +133,490 @@ namespace nohs{
         BasisSet = BasisSet_;
     }
 
+    Solver::Solver(unsigned int N_, PolynomialPotential V_) : Solver(N_, &PolynomialPotential::function, nullptr) {
+        polynomial = true;
+        polynomial_potential = V_;
+    }
+
+    Solver::Solver(std::vector<Hermite> BasisSet_, PolynomialPotential V_) : Solver(BasisSet_.size(), V_) {
+        BasisSet = BasisSet_;
+    }
+
+    Solver::~Solver() {}
+
     void Solver::set_integration_parameters(unsigned int npt_, double abs_, double rel_){
+        set_integration_parameters(integration, npt_, abs_, rel_);                                  //Checked against the current integration routine
+    }
+
+    void Solver::set_integration_parameters(Integration method_, unsigned int npt_, double abs_, double rel_){
+        if(method_ == Integration::GAUSS_HERMITE && (npt_ < 1 || npt_ > 200)) throw exceptions::InvalidError();
         npt = npt_; abs = abs_, rel = rel_;
+        integration = method_;
+        N_assembled = 0;
+    }
+
+    void Solver::set_assembly_mode(Assembly mode_){
+        mode = mode_;
+        N_assembled = 0;
+    }
+
+    void Solver::set_grid_parameters(double margin_, double density_){
+        if(margin_ <= 0. || density_ <= 0.) throw exceptions::InvalidError();
+        margin = margin_; density = density_;
+        N_assembled = 0;
+    }
+
+    void Solver::set_reflection_symmetry(bool enable_){
+        reflection = enable_;
+        N_assembled = 0;
+    }
+
+    void Solver::set_storage(Storage storage_){
+        storage = storage_;
+        N_assembled = 0;
+    }
+
+    void Solver::set_screening(double tolerance_){
+        if(tolerance_ < 0.) throw exceptions::InvalidError();
+        screening = tolerance_;
+        N_assembled = 0;
+    }
+
+    void Solver::set_sparse_parameters(unsigned int max_iter_, double tol_){
+        if(max_iter_ == 0 || tol_ <= 0.) throw exceptions::InvalidError();
+        sparse_max_iter = max_iter_; sparse_tol = tol_;
+    }
+
+    void Solver::set_workspace_pool(std::shared_ptr<utils::WorkspacePool> pool_){
+        if(pool_ == nullptr) throw exceptions::InvalidError();
+        pool = pool_;
+    }
+
+    void Solver::set_profiling(bool enable_){
+        profiling = enable_;
+        profile = Profile();
+    }
+
+    void Solver::set_distributed(bool enable_){
+        distribute = enable_;
     }
 
     void Solver::add(Hermite function_){
-        if(int(BasisSet.size()) >= N) throw exceptions::MaxDimensionError();
+        if(int(BasisSet.size()) >= N){
+            if(N_assembled == 0) throw exceptions::MaxDimensionError();
+            N++;                                                                                    //The basis-set of an assembled solver can be extended
+        }
         BasisSet.push_back(function_);
+        solved = false;
+        reuse = true;
     }
 
-    void Solver::solve(double threshold_){
+    void Solver::build_groups(){
+        groups.clear();
+        for(int i=0; i<N; i++){
+            bool found = false;
+            for(int g=0; g<int(groups.size()); g++){
+                const Hermite& first = BasisSet[groups[g][0]];
+                if(first.get_alpha() == BasisSet[i].get_alpha() && first.get_center() == BasisSet[i].get_center()){
+                    groups[g].push_back(i);
+                    found = true;
+                    break;
+                }
+            }
+            if(found == false) groups.push_back(std::vector<int>(1, i));
+        }
+    }
+
+    void Solver::evaluate_basis(int npt_, const double* x_, int ld_, double* F_, double* D1_, double* D2_){
+        for(int g=0; g<int(groups.size()); g++){
+            int max_order = 0;
+            for(int i : groups[g]) max_order = std::max(max_order, BasisSet[i].get_order());
+            const Hermite& first = BasisSet[groups[g][0]];
+            HermiteFamily family(max_order, first.get_alpha(), first.get_center());
+            int size = (max_order+1)*npt_;
+            std::vector<double> f(size), d1(D1_ == nullptr ? 0 : size), d2(D2_ == nullptr ? 0 : size);
+            family.evaluate(npt_, x_, f.data(), D1_ == nullptr ? nullptr : d1.data(), D2_ == nullptr ? nullptr : d2.data());
+            for(int i : groups[g]){
+                int order = BasisSet[i].get_order();
+                if(F_ != nullptr){
+                    for(int k=0; k<npt_; k++) F_[i*ld_ + k] = f[order*npt_ + k];
+                }
+                if(D1_ != nullptr){
+                    for(int k=0; k<npt_; k++) D1_[i*ld_ + k] = d1[order*npt_ + k];
+                }
+                if(D2_ != nullptr){
+                    for(int k=0; k<npt_; k++) D2_[i*ld_ + k] = d2[order*npt_ + k];
+                }
+            }
+        }
+    }
+
+    // Potential blocks of each group of functions sharing alpha and center in the discrete variable representation:
+    // the elements are computed with the Gauss-Hermite rule with max_order+1 nodes centered on the group, so that
+    // the potential is computed only once on each node.
+    // The DVR elements are approximate while the overlap, the kinetic and the elements between different groups are
+    // exact: if a group overlaps other groups this inconsistency is amplified by the near linear dependencies of the
+    // basis-set. Only the groups whose elements with every other group are negligible get a DVR block, the others are
+    // left empty and integrated by the selected backend.
+    std::vector<arma::mat> Solver::dvr_blocks(){
+        std::vector<int> group_order(groups.size(), 0);
+        for(int g=0; g<int(groups.size()); g++){
+            for(int i : groups[g]) group_order[g] = std::max(group_order[g], BasisSet[i].get_order());
+        }
+        double tolerance = std::max(screening, 1e-10);
+
+        std::vector<arma::mat> blocks(groups.size());
+        for(int g=0; g<int(groups.size()); g++){
+            const Hermite& a = BasisSet[groups[g][0]];
+            bool isolated = true;
+            for(int h=0; h<int(groups.size()) && isolated == true; h++){
+                const Hermite& b = BasisSet[groups[h][0]];
+                if(h != g && screening_estimate(a.get_alpha(), a.get_center(), group_order[g], b.get_alpha(), b.get_center(), group_order[h]) >= tolerance) isolated = false;
+            }
+            if(isolated == false) continue;
+
+            int max_order = group_order[g];
+            int n = max_order+1;
+            const Hermite& first = BasisSet[groups[g][0]];
+            double alpha = first.get_alpha(), center = first.get_center();
+
+            integrals::GaussHermiteTable table;
+            table.add(n);
+            const arma::vec& t = table.get_nodes(n);
+            const arma::vec& w = table.get_weights(n);
+            std::vector<double> x(n), V_x(n), f(n*n);
+            for(int k=0; k<n; k++) x[k] = center + t(k)/alpha;
+            potential(n, x.data(), V_x.data());
+            if(profiling == true) profile.potential_evaluations += n;
+            HermiteFamily family(max_order, alpha, center);
+            family.evaluate(n, x.data(), f.data(), nullptr, nullptr);
+
+            int M = int(groups[g].size());
+            arma::mat F = arma::mat(n, M, arma::fill::zeros);
+            arma::mat WF = arma::mat(n, M, arma::fill::zeros);
+            for(int col=0; col<M; col++){
+                int order = BasisSet[groups[g][col]].get_order();
+                for(int k=0; k<n; k++){
+                    F(k, col) = f[order*n + k];
+                    WF(k, col) = w(k)*V_x[k]*f[order*n + k]/alpha;
+                }
+            }
+            blocks[g] = F.t() * WF;
+        }
+        return blocks;
+    }
+
+    void Solver::integrate_pairs(const std::vector<std::pair<int, int>>& pairs, const std::vector<arma::mat>* dvr){
+
+        if(polynomial == false && integration != Integration::GAUSS_HERMITE) pool->reserve(max_threads(), npt);
+
+        build_groups();
+        std::vector<int> group_of(N, -1), local_of(N, -1), group_order(groups.size(), 0);
+        for(int g=0; g<int(groups.size()); g++){
+            for(int l=0; l<int(groups[g].size()); l++){
+                group_of[groups[g][l]] = g;
+                local_of[groups[g][l]] = l;
+                group_order[g] = std::max(group_order[g], BasisSet[groups[g][l]].get_order());
+            }
+        }
+
+        // Only the rules required by the couples of groups actually present are added, before the parallel region,
+        // since the table is then read concurrently by the threads
+        int extra_degree = polynomial == true ? std::max(2, polynomial_potential.degree()) : 2;
+        std::vector<bool> required;
+        for(int p=0; p<int(pairs.size()); p++){
+            int n = (group_order[group_of[pairs[p].first]] + group_order[group_of[pairs[p].second]] + extra_degree)/2 + 1;
+            if(n > int(required.size())) required.resize(n, false);
+            required[n-1] = true;
+        }
+        integrals::GaussHermiteTable table;
+        for(int n=1; n<=int(required.size()); n++){
+            if(required[n-1] == true) table.add(n);
+        }
+        if(polynomial == false && integration == Integration::GAUSS_HERMITE) table.add(npt);
+
+        // The pairs between the same two groups are contiguous: each thread keeps the functions of its last couple of
+        // groups computed on the exact rule (overlap, kinetic and polynomial potential) and, for the Gauss-Hermite
+        // backend, on the npt nodes rule together with the potential, so that every pair costs a sum over the nodes.
+        bool rule = polynomial == false && integration == Integration::GAUSS_HERMITE;
+        utils::PairIntegrand integrand = pair_integrand();
+        std::vector<std::pair<int, int>> block_key(max_threads(), std::make_pair(-1, -1));
+        std::vector<integrals::ProductBlock> exact_block(max_threads()), rule_block(max_threads());
+
+        bool sparse = storage == Storage::SPARSE;
+        std::vector<double> S_values(pairs.size(), 0.), H_values(pairs.size(), 0.);
+
+        int threads = profiling == true ? max_threads() : 0;                                         //Each thread records its own counters and busy time
+        std::vector<Profile> thread_profile(threads);
+        std::vector<double> busy(threads, 0.);
+
+        // In the MPI build the pairs are split in chunks dynamically assigned to the processes, each chunk being
+        // integrated by the OpenMP threads of its process. Every pair is integrated by a single process, the others
+        // contribute zero, so that the final sum gives the same matrices on every process.
+        long P = long(pairs.size());
+        bool split = distribute == true && distributed::active();
+        long chunk = split == true ? std::max(4L*max_threads(), P/(16L*distributed::size())) : P;
+        distributed::Counter counter(P, chunk, split);
+        long begin = 0, end = 0;
+        while(counter.next(begin, end) == true){
+            #ifdef _OPENMP
+                #pragma omp parallel for schedule(dynamic, 4)
+            #endif
+            for(int p=int(begin); p<int(end); p++){
+                double start = profiling == true ? utils::wall_time() : 0.;
+                Profile* local = profiling == true ? &thread_profile[thread_id()] : nullptr;
+                int row = pairs[p].first, col = pairs[p].second;
+                int t = thread_id();
+                int g = std::min(group_of[row], group_of[col]), h = std::max(group_of[row], group_of[col]);
+                int order_g = BasisSet[group_of[row] == g ? row : col].get_order(), order_h = BasisSet[group_of[row] == g ? col : row].get_order();
+                if(block_key[t] != std::make_pair(g, h)){
+                    const Hermite& a = BasisSet[groups[g][0]];
+                    const Hermite& b = BasisSet[groups[h][0]];
+                    int degree = group_order[g] + group_order[h] + extra_degree;
+                    exact_block[t] = integrals::ProductBlock(a, group_order[g], b, group_order[h], degree/2 + 1, table, kinetic);
+                    if(polynomial == true){
+                        const std::vector<double>& x = exact_block[t].get_points();
+                        std::vector<double> V_x(x.size());
+                        for(int k=0; k<int(x.size()); k++) V_x[k] = polynomial_potential(x[k]);
+                        exact_block[t].set_potential(V_x.data());
+                    }
+                    if(rule == true && (dvr == nullptr || g != h || (*dvr)[g].n_elem == 0)){
+                        rule_block[t] = integrals::ProductBlock(a, group_order[g], b, group_order[h], npt, table, false);
+                        std::vector<double> V_x(npt);
+                        potential(npt, rule_block[t].get_points().data(), V_x.data());
+                        rule_block[t].set_potential(V_x.data());
+                        if(local != nullptr) local->potential_evaluations += npt;
+                    }
+                    block_key[t] = std::make_pair(g, h);
+                }
+                double S_value = exact_block[t].overlap(order_g, order_h);
+                double H_value = kinetic == true ? exact_block[t].kinetic(order_g, order_h) : 0.;
+                if(polynomial == true){
+                    H_value += exact_block[t].potential(order_g, order_h);
+                }
+                else if(dvr != nullptr && group_of[row] == group_of[col] && (*dvr)[group_of[row]].n_elem != 0){
+                    H_value += (*dvr)[group_of[row]](local_of[row], local_of[col]);
+                }
+                else{
+                    const Hermite& a = BasisSet[row];
+                    const Hermite& b = BasisSet[col];
+                    utils::PairCarrier data = {this, a.get_order(), b.get_order(), a.get_alpha(), a.get_center(), b.get_alpha(), b.get_center()};
+                    double lower, upper;
+                    if(integration == Integration::GAUSS_HERMITE){
+                        H_value += rule_block[t].potential(order_g, order_h);
+                        if(local != nullptr) local->integrand_evaluations += npt;
+                    }
+                    else if(integration == Integration::QAG){
+                        if(integration_window(BasisSet[row], BasisSet[col], margin, lower, upper) == true){
+                            H_value += QAG_integrator(integrand, &data, pool->get(thread_id()), npt, abs, rel, lower, upper, local);
+                        }
+                    }
+                    else{
+                        H_value += QAGI_integrator(integrand, &data, pool->get(thread_id()), npt, abs, rel, local);
+                    }
+                }
+                if(local != nullptr){
+                    local->pairs++;
+                    busy[thread_id()] += utils::wall_time() - start;
+                }
+                S_values[p] = S_value; H_values[p] = H_value;
+            }
+        }
+
+        if(split == true){
+            distributed::sum(S_values);
+            distributed::sum(H_values);
+        }
+
+        if(sparse == false){
+            for(int p=0; p<int(pairs.size()); p++){
+                int row = pairs[p].first, col = pairs[p].second;
+                S(row, col) = S_values[p]; S(col, row) = S_values[p];
+                H(row, col) = H_values[p]; H(col, row) = H_values[p];
+                if(reflection == true){
+                    int m_row = mirror[row], m_col = mirror[col];
+                    double sign = (BasisSet[row].get_order() + BasisSet[col].get_order())%2 == 0 ? 1. : -1.;
+                    S(m_row, m_col) = sign*S_values[p]; S(m_col, m_row) = sign*S_values[p];
+                    H(m_row, m_col) = sign*H_values[p]; H(m_col, m_row) = sign*H_values[p];
+                }
+            }
+        }
+
+        for(int t=0; t<threads; t++){
+            thread_profile[t].thread_busy = std::vector<double>(threads, 0.);
+            thread_profile[t].thread_busy[t] = busy[t];
+            thread_profile[t].thread_pairs = std::vector<long>(threads, 0);
+            thread_profile[t].thread_pairs[t] = thread_profile[t].pairs;
+            profile.accumulate(thread_profile[t]);
+        }
+
+        if(sparse == true){                                                                         //Batch insertion of both the triangles
+            int nnz = 0;
+            for(int p=0; p<int(pairs.size()); p++) nnz += pairs[p].first == pairs[p].second ? 1 : 2;
+            arma::umat locations = arma::umat(2, nnz);
+            arma::vec S_batch = arma::vec(nnz), H_batch = arma::vec(nnz);
+            for(int p=0, k=0; p<int(pairs.size()); p++){
+                locations(0, k) = pairs[p].first; locations(1, k) = pairs[p].second;
+                S_batch(k) = S_values[p]; H_batch(k) = H_values[p];
+                k++;
+                if(pairs[p].first == pairs[p].second) continue;
+                locations(0, k) = pairs[p].second; locations(1, k) = pairs[p].first;
+                S_batch(k) = S_values[p]; H_batch(k) = H_values[p];
+                k++;
+            }
+            S_sparse = arma::sp_mat(locations, S_batch, N, N);
+            H_sparse = arma::sp_mat(locations, H_batch, N, N);
+        }
+    }
+
+    void Solver::quadrature_assembly(){
 
+        // Only the unique (row <= col) pairs are integrated. If the reflection symmetry is enabled only one
+        // pair of each {(row, col), (mirror[row], mirror[col])} couple is integrated and the other is
+        // obtained from <i|O|j> = (-1)^(n_i+n_j) <mirror[i]|O|mirror[j]>. If the basis-set has been extended
+        // after a previous assembly only the columns of the new functions are integrated. If the screening is
+        // enabled whole blocks of groups, and then single pairs, with a negligible estimate are skipped. In the
+        // DVR mode the potential elements within each group are taken from the DVR blocks.
+        int first = (reflection == true || storage == Storage::SPARSE || mode == Assembly::DVR) ? 0 : N_assembled;
+        if(storage == Storage::DENSE){
+            if(first == 0){
+                S.zeros(N, N);
+                H.zeros(N, N);
+            }
+            else{
+                S.resize(N, N);
+                H.resize(N, N);
+            }
+        }
+
+        std::vector<int> group_order(groups.size(), 0);
+        for(int g=0; g<int(groups.size()); g++){
+            for(int i : groups[g]) group_order[g] = std::max(group_order[g], BasisSet[i].get_order());
+        }
+
+        std::vector<std::pair<int, int>> pairs;
+        for(int g=0; g<int(groups.size()); g++){
+            for(int h=g; h<int(groups.size()); h++){
+                const Hermite& a = BasisSet[groups[g][0]];
+                const Hermite& b = BasisSet[groups[h][0]];
+                if(screening > 0. && screening_estimate(a.get_alpha(), a.get_center(), group_order[g], b.get_alpha(), b.get_center(), group_order[h]) < screening) continue;
+                for(int i : groups[g]){
+                    for(int j : groups[h]){
+                        if(g == h && j < i) continue;
+                        int row = std::min(i, j), col = std::max(i, j);
+                        if(col < first) continue;
+                        if(screening > 0. && screening_estimate(BasisSet[row], BasisSet[col]) < screening) continue;
+                        if(reflection == true){
+                            int m_row = std::min(mirror[row], mirror[col]), m_col = std::max(mirror[row], mirror[col]);
+                            if(m_row < row || (m_row == row && m_col < col)) continue;
+                        }
+                        pairs.push_back(std::make_pair(row, col));
+                    }
+                }
+            }
+        }
+
+        std::vector<arma::mat> dvr;
+        if(mode == Assembly::DVR && polynomial == false) dvr = dvr_blocks();
+        integrate_pairs(pairs, dvr.empty() == true ? nullptr : &dvr);
+    }
+
+    std::vector<double> Solver::basis_grid(double& step_){
+
+        // A uniform grid covers the classical region of every basis function plus `margin`/alpha.
+        // The spacing resolves the largest wavenumber found in a product of two basis functions so
+        // that the trapezoidal rule converges exponentially for all the Gaussian-enveloped integrands.
+        double x_min = BasisSet[0].get_center(), x_max = x_min, k_max = 0.;
+        for(int i=0; i<N; i++){
+            double k = std::sqrt(2.*BasisSet[i].get_order() + 1.) + margin;
+            double radius = k/BasisSet[i].get_alpha();
+            x_min = std::min(x_min, BasisSet[i].get_center() - radius);
+            x_max = std::max(x_max, BasisSet[i].get_center() + radius);
+            k_max = std::max(k_max, k*BasisSet[i].get_alpha());
+        }
+        int G = int(std::ceil(2.*density*k_max*(x_max - x_min)/M_PI)) + 1;
+        step_ = (x_max - x_min)/(G-1);
+        std::vector<double> x(G);
+        for(int k=0; k<G; k++) x[k] = x_min + k*step_;
+        return x;
+    }
+
+    void Solver::grid_assembly(){
+
+        double step;
+        std::vector<double> x = basis_grid(step);
+        int G = int(x.size());
+
+        arma::mat F = arma::mat(G, N, arma::fill::zeros);
+        arma::mat D = arma::mat(G, N, arma::fill::zeros);
+        arma::mat WF = arma::mat(G, N, arma::fill::zeros);
+        arma::mat WD = arma::mat(G, N, arma::fill::zeros);
+        arma::mat WVF = arma::mat(G, N, arma::fill::zeros);
+        arma::vec Vx = arma::vec(G, arma::fill::zeros);
+        if(profiling == true) profile.potential_evaluations += G;
+
+        const int chunk = 256;
         #ifdef _OPENMP
-            #pragma omp parallel for collapse(2) schedule(dynamic, 4)
+            #pragma omp parallel for schedule(dynamic, 1)
         #endif
-        for(int row=0; row<N; row++){
-            for(int col=0; col<N; col++){
-                utils::Carrier data(this, &Solver::overlap_integrand, row , col);
-                S(row, col) = QAGI_integrator(&utils::aux_func_gsl, &data, npt, abs, rel);
-                data.fpt = &Solver::hamiltonian_integrand;
-                H(row, col) = QAGI_integrator(&utils::aux_func_gsl, &data, npt, abs, rel);
+        for(int start=0; start<G; start+=chunk){
+            int m = std::min(chunk, G-start);
+            potential(m, x.data()+start, Vx.memptr()+start);
+            evaluate_basis(m, x.data()+start, G, F.memptr()+start, D.memptr()+start, nullptr);
+        }
+
+        #ifdef _OPENMP
+            #pragma omp parallel for schedule(dynamic, 4)
+        #endif
+        for(int col=0; col<N; col++){
+            for(int k=0; k<G; k++){
+                WF(k, col) = step*F(k, col);
+                WD(k, col) = step*D(k, col);
+                WVF(k, col) = Vx(k)*WF(k, col);
+            }
+        }
+
+        S = F.t() * WF;
+        H = F.t() * WVF;
+        if(kinetic == true) H += D.t() * WD;
+    }
+
+    void Solver::build_mirror(){
+        mirror = std::vector<int>(N, -1);
+        for(int i=0; i<N; i++){
+            double tolerance = 1e-12*std::max(1., std::fabs(BasisSet[i].get_center()));
+            for(int j=0; j<N; j++){
+                if(BasisSet[j].get_order() != BasisSet[i].get_order()) continue;
+                if(std::fabs(BasisSet[j].get_alpha() - BasisSet[i].get_alpha()) > 1e-12*BasisSet[i].get_alpha()) continue;
+                if(std::fabs(BasisSet[j].get_center() + BasisSet[i].get_center()) > tolerance) continue;
+                mirror[i] = j;
+                break;
             }
+            if(mirror[i] == -1) throw exceptions::InvalidError();
         }
+    }
+
+    void Solver::solve(double threshold_){
+        solve(threshold_, 0);
+    }
+
+    void Solver::assemble(){
+
+        build_groups();
+        if(reflection == true) build_mirror();
+
+        if(N_assembled == N) return;
+        double start = profiling == true ? utils::wall_time() : 0.;
+        if(mode == Assembly::GRID) grid_assembly();
+        else quadrature_assembly();
+        if(profiling == true) profile.assembly += utils::wall_time() - start;
+
+        if(storage == Storage::SPARSE){                                                             //The sparse matrices are symmetric by construction
+            N_assembled = N;
+            return;
+        }
+
+        start = profiling == true ? utils::wall_time() : 0.;
 
         #ifdef _OPENMP
             #pragma omp parallel for schedule(dynamic, 4)
@@ -77,53 +631,122 @@ namespace nohs{
                 H(col, row) = H_average;
             }
         }
+        if(profiling == true) profile.symmetrization += utils::wall_time() - start;
+
+        N_assembled = N;
+    }
 
-        arma::mat Q = arma::mat(N, N, arma::fill::zeros);
-        arma::vec S_eval = arma::vec (N, arma::fill::zeros);
-        arma::eig_sym(S_eval, Q, S, "std");
+    void Solver::solve(double threshold_, int n_states_){
 
-        int stop_index = N-1;
-        while(stop_index > 0){
-            if(S_eval(stop_index-1) < threshold_){
-                break;
-            }
-            stop_index--;
+        if(storage == Storage::SPARSE && (n_states_ <= 0 || mode == Assembly::GRID || reflection == true)) throw exceptions::InvalidError();
+
+        // If the profiling is enabled timings collects the orthogonalization, transformation and diagonalization times
+        if(profiling == true) profile = Profile();
+        double start = profiling == true ? utils::wall_time() : 0.;
+        double timings[3] = {0., 0., 0.};
+        double* timer = profiling == true ? timings : nullptr;
+
+        // The stored matrix elements are reused only after add or load: otherwise the potential could have been
+        // changed through parameters_ and all the elements are recomputed.
+        if(reuse == false) N_assembled = 0;
+        reuse = false;
+        assemble();
+
+        if(storage == Storage::SPARSE){
+            double begin = profiling == true ? utils::wall_time() : 0.;
+            linalg::lobpcg(S_sparse, H_sparse, threshold_, n_states_, sparse_max_iter, sparse_tol, E, C);
+            if(profiling == true) timings[2] += utils::wall_time() - begin;
+            N_red = N;
+            N_states = int(E.n_elem);
+            solved = true;
+            if(profiling == true) finish_profile(profile, start, timings);
+            return;
         }
 
-        N_red = N - stop_index;
-        arma::mat Q_red = arma::mat(N, N_red, arma::fill::zeros);
+        if(reflection == false){
+            N_red = linalg::canonical_solve(S, H, threshold_, n_states_, E, C, timer);
+            N_states = int(E.n_elem);
+            solved = true;
+            if(profiling == true) finish_profile(profile, start, timings);
+            return;
+        }
 
-        #ifdef _OPENMP
-            #pragma omp parallel for schedule(dynamic, 4)
-        #endif
-        for(int col=0; col<N_red; col++){
-            double factor = 1./std::sqrt(S_eval(stop_index + col));
-            for(int row=0; row<N; row++){
-                Q_red(row, col) = Q(row, stop_index+col)*factor;
+        // Symmetry-adapted combinations: every function centered in the origin has the parity of its order
+        // while every mirror couple gives one even and one odd combination. The two blocks are solved apart.
+        std::vector<std::vector<int>> index(2);
+        std::vector<std::vector<double>> coefficient(2);
+        for(int i=0; i<N; i++){
+            double sign = BasisSet[i].get_order()%2 == 0 ? 1. : -1.;
+            if(mirror[i] == i){
+                int block = sign > 0. ? 0 : 1;
+                index[block].push_back(i); index[block].push_back(i);
+                coefficient[block].push_back(1.); coefficient[block].push_back(0.);
+            }
+            else if(i < mirror[i]){
+                for(int block=0; block<2; block++){
+                    index[block].push_back(i); index[block].push_back(mirror[i]);
+                    coefficient[block].push_back(1./std::sqrt(2.)); coefficient[block].push_back((block == 0 ? 1. : -1.)*sign/std::sqrt(2.));
+                }
             }
         }
 
-        arma::mat H_red = arma::mat(N_red, N_red, arma::fill::zeros);
-        H_red = Q_red.t() * H * Q_red;
-
-        #ifdef _OPENMP
-            #pragma omp parallel for schedule(dynamic, 4)
-        #endif
-        for(int row=0; row<N_red; row++){
-            for(int col=0; col<=row; col++){
-                double average = 0.5*(H_red(row, col) + H_red(col, row));
-                H_red(row, col) = average;
-                H_red(col, row) = average;
+        std::vector<arma::vec> E_block(2);
+        std::vector<arma::mat> C_block(2);
+        N_red = 0;
+        for(int block=0; block<2; block++){
+            int M = int(index[block].size())/2;
+            if(M == 0) continue;
+            const std::vector<int>& idx = index[block];
+            const std::vector<double>& cf = coefficient[block];
+            double begin = profiling == true ? utils::wall_time() : 0.;
+            arma::mat S_block = arma::mat(M, M, arma::fill::zeros);
+            arma::mat H_block = arma::mat(M, M, arma::fill::zeros);
+            #ifdef _OPENMP
+                #pragma omp parallel for schedule(dynamic, 4)
+            #endif
+            for(int row=0; row<M; row++){
+                for(int col=0; col<M; col++){
+                    for(int a=0; a<2; a++){
+                        for(int b=0; b<2; b++){
+                            double factor = cf[2*row+a]*cf[2*col+b];
+                            S_block(row, col) += factor*S(idx[2*row+a], idx[2*col+b]);
+                            H_block(row, col) += factor*H(idx[2*row+a], idx[2*col+b]);
+                        }
+                    }
+                }
+            }
+            if(profiling == true) timings[1] += utils::wall_time() - begin;
+            arma::vec E_red;
+            arma::mat C_red;
+            N_red += linalg::canonical_solve(S_block, H_block, threshold_, n_states_, E_red, C_red, timer);
+            E_block[block] = E_red;
+            C_block[block] = arma::mat(N, E_red.n_elem, arma::fill::zeros);
+            for(int col=0; col<int(E_red.n_elem); col++){
+                for(int row=0; row<M; row++){
+                    C_block[block](idx[2*row], col) += cf[2*row]*C_red(row, col);
+                    C_block[block](idx[2*row+1], col) += cf[2*row+1]*C_red(row, col);
+                }
             }
         }
 
-        arma::mat C_red = arma::mat(N_red, N_red, arma::fill::zeros);
-        E = arma::vec(N_red, arma::fill::zeros);
-        arma::eig_sym(E, C_red, H_red, "std");
-        C = arma::mat(N, N_red, arma::fill::zeros);
-        C = Q_red * C_red;
+        int N_even = int(E_block[0].n_elem), N_odd = int(E_block[1].n_elem);
+        N_states = N_even + N_odd;
+        if(n_states_ > 0) N_states = std::min(N_states, n_states_);
+        E = arma::vec(N_states, arma::fill::zeros);
+        C = arma::mat(N, N_states, arma::fill::zeros);
+        state_parity = std::vector<int>(N_states, 0);
+        int even = 0, odd = 0;
+        for(int state=0; state<N_states; state++){                                                 //Merge the two sorted spectra
+            int block = (odd >= N_odd || (even < N_even && E_block[0](even) <= E_block[1](odd))) ? 0 : 1;
+            int& source = block == 0 ? even : odd;
+            E(state) = E_block[block](source);
+            for(int row=0; row<N; row++) C(row, state) = C_block[block](row, source);
+            state_parity[state] = block == 0 ? 1 : -1;
+            source++;
+        }
 
         solved = true;
+        if(profiling == true) finish_profile(profile, start, timings);
     }
 
     int Solver::get_N_reduced(){
@@ -131,20 +754,362 @@ namespace nohs{
         return N_red;
     }
 
+    int Solver::get_N_states(){
+        if(solved == false) throw exceptions::SolverError();
+        return N_states;
+    }
+
+    const Profile& Solver::get_profile(){
+        return profile;
+    }
+
     double Solver::energy(int index_){
         if(solved == false) throw exceptions::SolverError();
-        if(index_ < 0 || index_ >= N_red) throw exceptions::BoundError();
+        if(index_ < 0 || index_ >= N_states) throw exceptions::BoundError();
         return E(index_);
     }
 
+    int Solver::parity(int index_){
+        if(solved == false) throw exceptions::SolverError();
+        if(reflection == false) throw exceptions::InvalidError();
+        if(index_ < 0 || index_ >= N_states) throw exceptions::BoundError();
+        return state_parity[index_];
+    }
+
     double Solver::psi(int index_, double x_){
         if(solved == false) throw exceptions::SolverError();
-        if(index_ < 0 || index_ >= N_red) throw exceptions::BoundError();
+        if(index_ < 0 || index_ >= N_states) throw exceptions::BoundError();
+        std::vector<double> F(N);
+        evaluate_basis(1, &x_, 1, F.data(), nullptr, nullptr);
         double value = 0.;
         for(int i=0; i<N; i++){
-            value += C(i, index_)*BasisSet[i].f(x_);
+            value += C(i, index_)*F[i];
         }
         return value;
     }
 
+    arma::mat Solver::psi_grid(std::vector<int> index_list_, std::vector<double> x_, int derivative_){
+        if(solved == false) throw exceptions::SolverError();
+        if(derivative_ < 0 || derivative_ > 2) throw exceptions::InvalidError();
+        int k = int(index_list_.size()), G = int(x_.size());
+        arma::mat C_sub = arma::mat(N, k, arma::fill::zeros);
+        for(int j=0; j<k; j++){
+            if(index_list_[j] < 0 || index_list_[j] >= N_states) throw exceptions::BoundError();
+            for(int i=0; i<N; i++) C_sub(i, j) = C(i, index_list_[j]);
+        }
+
+        // The basis is computed on chunks of points so that the memory footprint does not grow with
+        // the grid size, each chunk is then projected on the requested eigenvectors by a single GEMM.
+        arma::mat result = arma::mat(G, k, arma::fill::zeros);
+        const int chunk = 256;
+        #ifdef _OPENMP
+            #pragma omp parallel for schedule(dynamic, 1)
+        #endif
+        for(int start=0; start<G; start+=chunk){
+            int m = std::min(chunk, G-start);
+            arma::mat B = arma::mat(m, N, arma::fill::zeros);
+            double* F = derivative_ == 0 ? B.memptr() : nullptr;
+            double* D1 = derivative_ == 1 ? B.memptr() : nullptr;
+            double* D2 = derivative_ == 2 ? B.memptr() : nullptr;
+            evaluate_basis(m, x_.data()+start, m, F, D1, D2);
+            arma::mat block = B * C_sub;
+            for(int j=0; j<k; j++){
+                for(int i=0; i<m; i++) result(start+i, j) = block(i, j);
+            }
+        }
+        return result;
+    }
+
+    arma::mat Solver::psi_all(std::vector<double> x_, int derivative_){
+        if(solved == false) throw exceptions::SolverError();
+        std::vector<int> index_list(N_states);
+        for(int i=0; i<N_states; i++) index_list[i] = i;
+        return psi_grid(index_list, x_, derivative_);
+    }
+
+    arma::mat Solver::density_grid(std::vector<int> index_list_, std::vector<double> x_){
+        arma::mat result = psi_grid(index_list_, x_, 0);
+        for(int i=0; i<int(result.n_elem); i++) result(i) *= result(i);
+        return result;
+    }
+
+    struct OperatorCarrier{
+        const Hermite* a;
+        const Hermite* b;
+        double (*O)(double, void*);
+        void* parameters;
+    };
+
+    static double operator_integrand(double x, void* pvoid){
+        const OperatorCarrier& data = *static_cast<const OperatorCarrier*>(pvoid);
+        return data.a->f(x)*data.O(x, data.parameters)*data.b->f(x);
+    }
+
+    // Matrix of a multiplicative operator in the basis-set: the elements are computed exactly for a polynomial operator
+    // and with the selected integration backend otherwise. The pairs discarded by the screening are left to zero.
+    arma::mat Solver::operator_matrix(double (*O_)(double, void*), void* parameters_, const PolynomialPotential* polynomial_){
+
+        // Only the rules required by the orders present in the basis-set are added before the parallel region
+        integrals::GaussHermiteTable table;
+        if(polynomial_ != nullptr){
+            std::vector<bool> present;
+            for(int i=0; i<N; i++){
+                int order = BasisSet[i].get_order();
+                if(order >= int(present.size())) present.resize(order+1, false);
+                present[order] = true;
+            }
+            for(int m=0; m<int(present.size()); m++){
+                for(int n=m; n<int(present.size()); n++){
+                    if(present[m] == true && present[n] == true) table.add((m + n + polynomial_->degree())/2 + 1);
+                }
+            }
+        }
+        if(polynomial_ == nullptr && integration == Integration::GAUSS_HERMITE) table.add(npt);
+        if(polynomial_ == nullptr && integration != Integration::GAUSS_HERMITE) pool->reserve(max_threads(), npt);
+
+        arma::mat O = arma::mat(N, N, arma::fill::zeros);
+        #ifdef _OPENMP
+            #pragma omp parallel for schedule(dynamic, 4)
+        #endif
+        for(int row=0; row<N; row++){
+            for(int col=row; col<N; col++){
+                const Hermite& a = BasisSet[row];
+                const Hermite& b = BasisSet[col];
+                if(screening > 0. && screening_estimate(a, b) < screening) continue;
+                double value = 0., lower, upper;
+                OperatorCarrier data = {&a, &b, O_, parameters_};
+                if(polynomial_ != nullptr){
+                    value = integrals::potential(a, b, *polynomial_, table);
+                }
+                else if(integration == Integration::GAUSS_HERMITE){
+                    value = integrals::product_rule(a, b, npt, table, &operator_integrand, &data);
+                }
+                else if(integration == Integration::QAG){
+                    if(integration_window(a, b, margin, lower, upper) == true){
+                        value = QAG_integrator(&operator_integrand, &data, pool->get(thread_id()), npt, abs, rel, lower, upper, nullptr);
+                    }
+                }
+                else{
+                    value = QAGI_integrator(&operator_integrand, &data, pool->get(thread_id()), npt, abs, rel, nullptr);
+                }
+                O(row, col) = value;
+                O(col, row) = value;
+            }
+        }
+        return O;
+    }
+
+    // Restriction of the operator O_ to the requested eigenstates, C'OC, with two matrix products
+    arma::mat Solver::project(std::vector<int> index_list_, const arma::mat& O_){
+        int k = int(index_list_.size());
+        arma::mat C_sub = arma::mat(N, k, arma::fill::zeros);
+        for(int j=0; j<k; j++){
+            for(int i=0; i<N; i++) C_sub(i, j) = C(i, index_list_[j]);
+        }
+        arma::mat OC = O_ * C_sub;
+        return C_sub.t() * OC;
+    }
+
+    arma::mat Solver::observable(std::vector<int> index_list_, double (*O_)(double, void*), void* parameters_){
+        if(solved == false) throw exceptions::SolverError();
+        if(O_ == nullptr) throw exceptions::InvalidError();
+        for(int index : index_list_){
+            if(index < 0 || index >= N_states) throw exceptions::BoundError();
+        }
+        return project(index_list_, operator_matrix(O_, parameters_, nullptr));
+    }
+
+    arma::mat Solver::observable(std::vector<int> index_list_, PolynomialPotential O_){
+        if(solved == false) throw exceptions::SolverError();
+        for(int index : index_list_){
+            if(index < 0 || index >= N_states) throw exceptions::BoundError();
+        }
+        return project(index_list_, operator_matrix(&PolynomialPotential::function, &O_, &O_));
+    }
+
+    // The key of a checkpoint covers everything the stored matrices depend upon: the basis-set, the potential (the
+    // coefficients of a polynomial potential or the user-provided key_ values for a generic one) and the assembly,
+    // integration and symmetry settings.
+    uint64_t Solver::checkpoint_hash(const std::vector<Hermite>& BasisSet_, const std::vector<double>& key_){
+        checkpoint::Hash hash;
+        hash.add(uint64_t(BasisSet_.size()));
+        for(const Hermite& function : BasisSet_){
+            hash.add(int64_t(function.get_order()));
+            hash.add(function.get_alpha());
+            hash.add(function.get_center());
+        }
+        hash.add(int32_t(polynomial));
+        if(polynomial == true){
+            for(int power=0; power<=polynomial_potential.degree(); power++) hash.add(polynomial_potential.coefficient(power));
+        }
+        hash.add(uint64_t(key_.size()));
+        for(double value : key_) hash.add(value);
+        hash.add(int32_t(mode)); hash.add(int32_t(integration)); hash.add(int32_t(storage));
+        hash.add(int32_t(reflection)); hash.add(int32_t(kinetic));
+        hash.add(int64_t(npt)); hash.add(abs); hash.add(rel);
+        hash.add(margin); hash.add(density); hash.add(screening);
+        return hash.get();
+    }
+
+    // Binary layout: a checkpoint::Header followed by the basis-set (order, alpha and center of each function),
+    // the S and H matrices (dense column-major or row, column and value arrays of the non-zero elements), the
+    // eigenvalues, the eigenvectors and the state parities. Each section is padded to checkpoint::alignment bytes
+    // so that the dense matrices can be used directly from the memory-mapped file.
+    void Solver::save(std::string path_, std::vector<double> key_){
+        if(solved == false) throw exceptions::SolverError();
+        bool sparse = storage == Storage::SPARSE;
+
+        checkpoint::Header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, checkpoint::magic, sizeof(header.magic));
+        header.version = checkpoint::version;
+        header.flags = (sparse == true ? checkpoint::sparse_flag : 0) | (reflection == true ? checkpoint::reflection_flag : 0);
+        header.hash = checkpoint_hash(BasisSet, key_);
+        header.N = N; header.N_red = N_red; header.N_states = N_states;
+        header.nnz_S = sparse == true ? S_sparse.n_nonzero : 0;
+        header.nnz_H = sparse == true ? H_sparse.n_nonzero : 0;
+
+        std::ofstream file(path_, std::ios::binary | std::ios::trunc);
+        if(!file) throw exceptions::CheckpointError();
+        auto write = [&file](const void* data, size_t size){
+            static const char padding[checkpoint::alignment] = {0};
+            if(size > 0) file.write(static_cast<const char*>(data), size);
+            file.write(padding, checkpoint::aligned(size) - size);
+        };
+        auto write_sparse = [&write](const arma::sp_mat& M){
+            std::vector<uint64_t> rows, cols;
+            std::vector<double> values;
+            for(arma::sp_mat::const_iterator it=M.begin(); it!=M.end(); ++it){
+                rows.push_back(it.row()); cols.push_back(it.col()); values.push_back(*it);
+            }
+            write(rows.data(), rows.size()*sizeof(uint64_t));
+            write(cols.data(), cols.size()*sizeof(uint64_t));
+            write(values.data(), values.size()*sizeof(double));
+        };
+
+        write(&header, sizeof(header));
+        std::vector<double> basis(3*N);
+        for(int i=0; i<N; i++){
+            basis[3*i] = BasisSet[i].get_order();
+            basis[3*i+1] = BasisSet[i].get_alpha();
+            basis[3*i+2] = BasisSet[i].get_center();
+        }
+        write(basis.data(), basis.size()*sizeof(double));
+        if(sparse == true){
+            write_sparse(S_sparse);
+            write_sparse(H_sparse);
+        }
+        else{
+            write(S.memptr(), S.n_elem*sizeof(double));
+            write(H.memptr(), H.n_elem*sizeof(double));
+        }
+        write(E.memptr(), E.n_elem*sizeof(double));
+        write(C.memptr(), C.n_elem*sizeof(double));
+        std::vector<int64_t> parity(N_states, 0);
+        for(int i=0; i<int(state_parity.size()) && i<N_states; i++) parity[i] = state_parity[i];
+        write(parity.data(), parity.size()*sizeof(int64_t));
+
+        if(!file) throw exceptions::CheckpointError();
+    }
+
+    // If the solver has been constructed without basis functions the basis-set is taken from the checkpoint, otherwise
+    // it must coincide with the stored one. The dense matrices alias the memory-mapped file (copy-on-write) without copies.
+    void Solver::load(std::string path_, std::vector<double> key_){
+        size_t size = 0;
+        std::shared_ptr<char> data = checkpoint::map_file(path_, size);
+
+        checkpoint::Header header;
+        if(size < sizeof(header)) throw exceptions::CheckpointError();
+        std::memcpy(&header, data.get(), sizeof(header));
+        if(std::memcmp(header.magic, checkpoint::magic, sizeof(header.magic)) != 0 || header.version != checkpoint::version) throw exceptions::CheckpointError();
+
+        bool sparse = (header.flags & checkpoint::sparse_flag) != 0;
+        int n = int(header.N), n_states = int(header.N_states);
+        if(n <= 0 || n_states < 0 || n_states > n) throw exceptions::CheckpointError();
+
+        // The offsets of all the sections are validated before any data is read, and the new state is built in local
+        // objects that are assigned to the members only at the end: if the file is rejected the solver is left unchanged.
+        size_t offset = checkpoint::aligned(sizeof(header));
+        auto section = [&offset, size](uint64_t count, size_t element) -> size_t {
+            if(count > size/element || offset + count*element > size) throw exceptions::CheckpointError();
+            size_t start = offset;
+            offset += checkpoint::aligned(count*element);
+            return start;
+        };
+
+        size_t basis_at = section(3*uint64_t(n), sizeof(double));
+        size_t S_at[3] = {0, 0, 0}, H_at[3] = {0, 0, 0};
+        if(sparse == true){
+            for(size_t* at : {S_at, H_at}){
+                uint64_t nnz = at == S_at ? header.nnz_S : header.nnz_H;
+                at[0] = section(nnz, sizeof(uint64_t));
+                at[1] = section(nnz, sizeof(uint64_t));
+                at[2] = section(nnz, sizeof(double));
+            }
+        }
+        else{
+            S_at[0] = section(uint64_t(n)*n, sizeof(double));
+            H_at[0] = section(uint64_t(n)*n, sizeof(double));
+        }
+        size_t E_at = section(uint64_t(n_states), sizeof(double));
+        size_t C_at = section(uint64_t(n)*n_states, sizeof(double));
+        size_t parity_at = section(uint64_t(n_states), sizeof(int64_t));
+
+        const double* stored = reinterpret_cast<const double*>(data.get() + basis_at);
+        std::vector<Hermite> basis(n);
+        for(int i=0; i<n; i++) basis[i] = Hermite(int(stored[3*i]), stored[3*i+1], stored[3*i+2]);
+        if(BasisSet.empty() == false && int(BasisSet.size()) != n) throw exceptions::CheckpointError();
+        if(header.hash != checkpoint_hash(BasisSet.empty() == true ? basis : BasisSet, key_)) throw exceptions::CheckpointError();
+
+        auto read_sparse = [&data, n](const size_t* at, uint64_t nnz) -> arma::sp_mat {
+            const uint64_t* rows = reinterpret_cast<const uint64_t*>(data.get() + at[0]);
+            const uint64_t* cols = reinterpret_cast<const uint64_t*>(data.get() + at[1]);
+            const double* values = reinterpret_cast<const double*>(data.get() + at[2]);
+            arma::umat locations = arma::umat(2, nnz);
+            arma::vec entries = arma::vec(nnz);
+            for(uint64_t k=0; k<nnz; k++){
+                if(rows[k] >= uint64_t(n) || cols[k] >= uint64_t(n)) throw exceptions::CheckpointError();
+                locations(0, k) = rows[k];
+                locations(1, k) = cols[k];
+                entries(k) = values[k];
+            }
+            return arma::sp_mat(locations, entries, n, n);
+        };
+
+        arma::sp_mat S_sparse_new, H_sparse_new;
+        arma::mat S_new, H_new;
+        if(sparse == true){
+            S_sparse_new = read_sparse(S_at, header.nnz_S);
+            H_sparse_new = read_sparse(H_at, header.nnz_H);
+        }
+        else{
+            S_new = arma::mat(reinterpret_cast<double*>(data.get() + S_at[0]), n, n, false, false);
+            H_new = arma::mat(reinterpret_cast<double*>(data.get() + H_at[0]), n, n, false, false);
+        }
+        arma::vec E_new = arma::vec(reinterpret_cast<double*>(data.get() + E_at), n_states, false, false);
+        arma::mat C_new = arma::mat(reinterpret_cast<double*>(data.get() + C_at), n, n_states, false, false);
+        const int64_t* parity = reinterpret_cast<const int64_t*>(data.get() + parity_at);
+        std::vector<int> parity_new(parity, parity + n_states);
+
+        if(sparse == true){
+            S_sparse = std::move(S_sparse_new);
+            H_sparse = std::move(H_sparse_new);
+        }
+        else{
+            S = std::move(S_new);
+            H = std::move(H_new);
+        }
+        E = std::move(E_new);
+        C = std::move(C_new);
+        state_parity = std::move(parity_new);
+        if(BasisSet.empty() == true) BasisSet = basis;
+        N = n; N_red = int(header.N_red); N_states = n_states;
+        mapping = data;
+        build_groups();
+        if(reflection == true) build_mirror();
+        N_assembled = N;
+        reuse = true;
+        solved = true;
+    }
+
 }
\ No newline at end of file
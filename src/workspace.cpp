@@ -0,0 +1,34 @@
+#include <vector>
+#include <gsl/gsl_integration.h>
+
+#include "nohs.h"
+#include "nohs_exceptions.h"
+
+namespace nohs{
+    namespace utils{
+
+        WorkspacePool::WorkspacePool() : npt(0) {}
+
+        WorkspacePool::~WorkspacePool(){
+            for(gsl_integration_workspace* w : workspaces) gsl_integration_workspace_free(w);
+        }
+
+        void WorkspacePool::reserve(int threads_, size_t npt_){
+            if(threads_ < 1 || npt_ < 1) throw exceptions::InvalidError();
+            if(npt_ != npt){                                                                        //Workspaces of the wrong size cannot be reused
+                for(gsl_integration_workspace* w : workspaces) gsl_integration_workspace_free(w);
+                workspaces.clear();
+                npt = npt_;
+            }
+            while(int(workspaces.size()) < threads_){
+                workspaces.push_back(gsl_integration_workspace_alloc(npt));
+            }
+        }
+
+        gsl_integration_workspace* WorkspacePool::get(int thread_){
+            if(thread_ < 0 || thread_ >= int(workspaces.size())) throw exceptions::BoundError();
+            return workspaces[thread_];
+        }
+
+    }
+}
\ No newline at end of file